@@ -0,0 +1,30 @@
+#include "CachedDocument.h"
+#include <vector>
+
+using namespace std;
+using namespace tinyxml2;
+
+// Documents that aren't borrowed. Beyond a few, a thread is holding on to memory it doesn't need.
+constexpr size_t MAX_CACHED_DOCUMENTS = 4;
+static thread_local vector<unique_ptr<XMLDocument>> tDocuments;
+
+CachedDocument::CachedDocument()
+{
+	if (tDocuments.empty())
+	{
+		tDocuments.reserve(MAX_CACHED_DOCUMENTS);
+		mDocument = make_unique<XMLDocument>();
+	}
+	else
+	{
+		mDocument = move(tDocuments.back());
+		tDocuments.pop_back();
+	}
+}
+
+CachedDocument::~CachedDocument()
+{
+	mDocument->Clear();
+	if (tDocuments.size() < MAX_CACHED_DOCUMENTS)
+		tDocuments.push_back(move(mDocument));
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "tinyxml2.h"
+#include <memory>
+
+// Borrows an XMLDocument from a per-thread cache for the lifetime of this object, instead of constructing one.
+// Documents are cleared when returned but keep their node pools & parse buffer, so repeatedly loading files
+// of a similar size stops allocating once the cache is warm. Nested borrows on one thread get separate documents.
+class CachedDocument
+{
+public:
+	CachedDocument();
+	~CachedDocument();
+
+	CachedDocument(const CachedDocument&) = delete;
+	CachedDocument& operator=(const CachedDocument&) = delete;
+
+	tinyxml2::XMLDocument* Get() { return mDocument.get(); }
+	tinyxml2::XMLDocument& operator*() { return *mDocument; }
+	tinyxml2::XMLDocument* operator->() { return mDocument.get(); }
+
+private:
+	std::unique_ptr<tinyxml2::XMLDocument> mDocument;
+};
@@ -1,8 +1,20 @@
 #include "Core.h"
+#include "XmlBatch.h"
 #include "imgui/imgui_impl_sdl2.h"
 #include "imgui/imgui_impl_sdlrenderer.h"
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/imstb_rectpack.h"
 #include <cassert>
 #include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 using namespace std;
 
@@ -13,50 +25,387 @@ struct Time
 	double frame = 0.0;			// update + render
 	double smooth = 0.0;		// Average of update + render across samplesCount frames
 	double target = 1.0 / 60.0;	// Desired seconds per frame (frame rate, 60fps by default)
+	double error = 0.0;			// Difference between how long we waited and how long we wanted to wait
+	double sleepMargin = 0.002;	// Portion of a wait that's spun rather than slept (OS sleep is coarse)
+
+	double tick = 1.0 / 60.0;	// Fixed simulation step in seconds (tick rate, 60Hz by default)
+	double accumulator = 0.0;	// Frame time not yet consumed by ticks
+	int maxTicks = 5;			// Most ticks run per frame before dropping time (prevents a spiral of death)
+	int ticks = 0;				// Ticks run this frame
+	bool ticking = false;		// Whether a tick is in progress (input it saw is consumed at the next Tick call)
 
 	array<double, 10> samples;	// History of frame times
 	size_t frameCount = 0ULL;	// Frame counter
 
 	double previous = 0.0;	// Previous time query
 	double current = 0.0;	// Current time query
+
+	Uint64 start = SDL_GetPerformanceCounter();					// High-resolution clock at program start
+	double frequency = (double)SDL_GetPerformanceFrequency();	// High-resolution clock ticks per second
 } gTime;
 
 struct App
 {
 	bool running = false;
+	bool headless = false;	// No presentation or gui, dummy video & audio drivers
 	SDL_Window* window = nullptr;
 	SDL_Renderer* renderer = nullptr;
 	GuiCallback guiCallback = nullptr;
 	void* guiData = nullptr;
+	SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;	// Blend mode of solid colour draws
 
 	Point mousePosition{};
 	array<Uint8, SDL_NUM_SCANCODES> keyboardCurrent{};
 	array<Uint8, SDL_NUM_SCANCODES> keyboardPrevious{};
 } gApp;
 
+struct TextureCache
+{
+	struct Entry
+	{
+		Texture* texture = nullptr;
+		int references = 0;
+	};
+
+	unordered_map<string, Entry> entries;		// Image path -> shared texture
+	unordered_map<Texture*, string> paths;		// Shared texture -> image path (for unloading)
+} gTextures;
+
+struct Atlas
+{
+	vector<Texture*> pages;						// Packed images
+	unordered_map<string, Sprite> sprites;		// Image path -> region of a page
+	unordered_map<Texture*, SDL_Rect> whites;	// Page -> solid white region (lets solid colour draws share the page's batch)
+} gAtlas;
+
+enum AssetType : Uint8
+{
+	ASSET_TEXTURE,
+	ASSET_SOUND,
+	ASSET_MUSIC
+};
+
+struct AssetLoader
+{
+	struct Asset
+	{
+		AssetType type;
+		bool loading = true;
+		void* data = nullptr;	// Texture, Sound or Music once loaded
+	};
+
+	struct Job
+	{
+		Handle asset;
+		AssetType type;
+		string path;
+		void* result = nullptr;	// Decoded SDL_Surface (textures are created on the main thread), Sound or Music
+		string error;
+	};
+
+	Pool<Asset> assets;			// Only touched by the main thread
+	vector<thread> workers;		// Started by the first asynchronous load
+
+	mutex lock;					// Guards everything below
+	condition_variable wake;
+	deque<Job> pending;			// Waiting for a worker
+	vector<Job> completed;		// Decoded, waiting for the main thread
+	vector<Job> finishing;		// Swapped with completed so the lock isn't held while creating textures
+	bool stopping = false;
+} gAssets;
+
+struct SpriteBatch
+{
+	Texture* texture = nullptr;		// Texture shared by all queued quads (nullptr for solid colour)
+	vector<SDL_Vertex> vertices;	// 4 per quad
+	vector<int> indices;			// 6 per quad (2 triangles)
+	size_t drawCalls = 0;			// Flushes this frame
+} gBatch;
+
+// Submits all queued quads in a single SDL_RenderGeometry call
+void FlushBatch()
+{
+	if (!gBatch.indices.empty())
+	{
+		SDL_RenderGeometry(gApp.renderer, gBatch.texture,
+			gBatch.vertices.data(), (int)gBatch.vertices.size(),
+			gBatch.indices.data(), (int)gBatch.indices.size());
+		gBatch.drawCalls++;
+	}
+	gBatch.vertices.clear();
+	gBatch.indices.clear();
+}
+
+// Queues a quad (corners in clockwise order starting top-left), flushing first if the texture changes
+void BatchQuad(Texture* texture, const array<Point, 4>& corners, const array<Point, 4>& uvs, const Color& color)
+{
+	if (texture != gBatch.texture)
+	{
+		FlushBatch();
+		gBatch.texture = texture;
+	}
+
+	const int base = (int)gBatch.vertices.size();
+	for (size_t i = 0; i < corners.size(); i++)
+		gBatch.vertices.push_back({ corners[i], color, uvs[i] });
+
+	for (int index : { 0, 1, 2, 0, 2, 3 })
+		gBatch.indices.push_back(base + index);
+}
+
+// Queues a solid colour quad, drawing it from the current atlas page's white pixel when possible to avoid a flush
+void BatchSolid(const array<Point, 4>& corners, const Color& color)
+{
+	// Textured geometry uses the texture's blend mode, which only matches solid colour draws if opaque or already blending
+	auto white = gAtlas.whites.find(gBatch.texture);
+	if (white != gAtlas.whites.end() && (color.a == 255 || gApp.blendMode == SDL_BLENDMODE_BLEND))
+	{
+		int w, h;
+		SDL_QueryTexture(gBatch.texture, nullptr, nullptr, &w, &h);
+		Point uv{ (white->second.x + 0.5f) / w, (white->second.y + 0.5f) / h };
+		BatchQuad(gBatch.texture, corners, { uv, uv, uv, uv }, color);
+	}
+	else
+	{
+		BatchQuad(nullptr, corners, {}, color);
+	}
+}
+
+// Queues rect rotated clockwise about its centre (same as SDL_RenderCopyEx) showing the uvMin to uvMax region of texture
+void BatchSprite(Texture* texture, Point uvMin, Point uvMax, const Rect& rect, float degrees, Color tint)
+{
+	// A missing image draws nothing, as SDL_RenderCopy did
+	if (texture == nullptr) return;
+
+	Point centre{ rect.x + rect.w * 0.5f, rect.y + rect.h * 0.5f };
+	Point extents{ rect.w * 0.5f, rect.h * 0.5f };
+	array<Point, 4> corners{
+		Point{ -extents.x, -extents.y },
+		Point{ extents.x, -extents.y },
+		Point{ extents.x, extents.y },
+		Point{ -extents.x, extents.y } };
+
+	const float radians = degrees * DEG2RAD;
+	for (Point& corner : corners)
+		corner = centre + (degrees != 0.0f ? Rotate(corner, radians) : corner);
+
+	// Geometry ignores texture colour & alpha mod, so apply them per-vertex along with the tint
+	Color mod;
+	SDL_GetTextureColorMod(texture, &mod.r, &mod.g, &mod.b);
+	SDL_GetTextureAlphaMod(texture, &mod.a);
+	tint.r = tint.r * mod.r / 255;
+	tint.g = tint.g * mod.g / 255;
+	tint.b = tint.b * mod.b / 255;
+	tint.a = tint.a * mod.a / 255;
+
+	BatchQuad(texture, corners, {
+		Point{ uvMin.x, uvMin.y },
+		Point{ uvMax.x, uvMin.y },
+		Point{ uvMax.x, uvMax.y },
+		Point{ uvMin.x, uvMax.y } }, tint);
+}
+
+void AssetWorker()
+{
+	while (true)
+	{
+		AssetLoader::Job job;
+		{
+			unique_lock<mutex> lock(gAssets.lock);
+			gAssets.wake.wait(lock, [] { return gAssets.stopping || !gAssets.pending.empty(); });
+			if (gAssets.stopping) return;
+			job = move(gAssets.pending.front());
+			gAssets.pending.pop_front();
+		}
+
+		switch (job.type)
+		{
+		case ASSET_TEXTURE:
+			job.result = IMG_Load(job.path.c_str());
+			break;
+
+		case ASSET_SOUND:
+			job.result = Mix_LoadWAV(job.path.c_str());	// Converted to the mixer's PCM format
+			break;
+
+		case ASSET_MUSIC:
+			job.result = Mix_LoadMUS(job.path.c_str());
+			break;
+		}
+		if (job.result == nullptr) job.error = SDL_GetError();
+
+		lock_guard<mutex> lock(gAssets.lock);
+		gAssets.completed.push_back(move(job));
+	}
+}
+
+// Frees the result of a job nobody wants anymore
+void DiscardJob(AssetLoader::Job& job)
+{
+	if (job.result == nullptr) return;
+	switch (job.type)
+	{
+	case ASSET_TEXTURE:
+		SDL_FreeSurface((SDL_Surface*)job.result);
+		break;
+
+	case ASSET_SOUND:
+		Mix_FreeChunk((Sound*)job.result);
+		break;
+
+	case ASSET_MUSIC:
+		Mix_FreeMusic((Music*)job.result);
+		break;
+	}
+	job.result = nullptr;
+}
+
+Handle QueueLoad(AssetType type, const char* path)
+{
+	if (gAssets.workers.empty())
+	{
+		// Leave a core for the main thread
+		const unsigned int count = clamp<unsigned int>(thread::hardware_concurrency(), 2, 5) - 1;
+		for (unsigned int i = 0; i < count; i++)
+			gAssets.workers.emplace_back(AssetWorker);
+	}
+
+	if (gAssets.assets.Full())
+		gAssets.assets.Reserve(max<size_t>(gAssets.assets.Capacity() * 2, 64));
+
+	AssetLoader::Asset asset;
+	asset.type = type;
+	Handle handle = gAssets.assets.Add(asset);
+	{
+		lock_guard<mutex> lock(gAssets.lock);
+		gAssets.pending.push_back({ handle, type, path, nullptr, {} });
+	}
+	gAssets.wake.notify_one();
+	return handle;
+}
+
+// Hands decoded assets to their handles, creating textures for images (the renderer can only be used on the main thread)
+void FinishLoads()
+{
+	{
+		lock_guard<mutex> lock(gAssets.lock);
+		if (gAssets.completed.empty()) return;
+		swap(gAssets.completed, gAssets.finishing);
+	}
+
+	PROFILE_SCOPE("Finish Loads");
+	for (AssetLoader::Job& job : gAssets.finishing)
+	{
+		AssetLoader::Asset* asset = gAssets.assets.Get(job.asset);
+		if (asset == nullptr)
+		{
+			// Unloaded before it finished loading
+			DiscardJob(job);
+			continue;
+		}
+
+		asset->loading = false;
+		if (job.result == nullptr)
+		{
+			SDL_Log("Failed to load %s: %s", job.path.c_str(), job.error.c_str());
+			continue;
+		}
+
+		if (job.type != ASSET_TEXTURE)
+		{
+			asset->data = job.result;
+			continue;
+		}
+
+		// Another load may have cached the texture while this one was decoding
+		TextureCache::Entry& entry = gTextures.entries[job.path];
+		if (entry.texture == nullptr)
+		{
+			entry.texture = SDL_CreateTextureFromSurface(gApp.renderer, (SDL_Surface*)job.result);
+			if (entry.texture != nullptr)
+				gTextures.paths[entry.texture] = job.path;
+		}
+		DiscardJob(job);
+
+		if (entry.texture == nullptr)
+		{
+			gTextures.entries.erase(job.path);
+			continue;
+		}
+		entry.references++;
+		asset->data = entry.texture;
+	}
+	gAssets.finishing.clear();
+}
+
+void StopLoads()
+{
+	{
+		lock_guard<mutex> lock(gAssets.lock);
+		gAssets.stopping = true;
+	}
+	gAssets.wake.notify_all();
+	for (thread& worker : gAssets.workers)
+		worker.join();
+	gAssets.workers.clear();
+
+	for (AssetLoader::Job& job : gAssets.completed)
+		DiscardJob(job);
+	gAssets.completed.clear();
+	gAssets.pending.clear();
+
+	// Textures are freed along with the texture cache
+	for (AssetLoader::Asset& asset : gAssets.assets)
+	{
+		if (asset.type == ASSET_SOUND) Mix_FreeChunk((Sound*)asset.data);
+		if (asset.type == ASSET_MUSIC) Mix_FreeMusic((Music*)asset.data);
+	}
+	gAssets.assets.Clear();
+}
+
+void PoolGui(const char* name, const PoolUsage& usage)
+{
+	char overlay[64];
+	snprintf(overlay, sizeof(overlay), "%zu / %zu (peak %zu)", usage.count, usage.capacity, usage.highWater);
+	ImGui::ProgressBar(usage.capacity > 0 ? usage.count / (float)usage.capacity : 0.0f, { 0.0f, 0.0f }, overlay);
+	ImGui::SameLine();
+	ImGui::Text("%s", name);
+}
+
 void SetGuiCallback(GuiCallback callback, void* data)
 {
 	gApp.guiCallback = callback;
 	gApp.guiData = data;
 }
 
-void AppInit(int width, int height)
+void AppInit(int width, int height, bool headless)
 {
 	assert(!gApp.running);
 	assert(gApp.window == nullptr);
 	assert(gApp.renderer == nullptr);
 
+	// Dummy drivers still give us a (software) renderer so scenes can load textures without a display or GPU
+	gApp.headless = headless;
+	if (headless)
+	{
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+		SDL_SetHint(SDL_HINT_AUDIODRIVER, "dummy");
+	}
+
 	assert(SDL_Init(SDL_INIT_EVERYTHING) == 0);
 	assert(Mix_OpenAudio(48000, AUDIO_S16SYS, 2, 2048) == 0);
 	assert(IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG) == IMG_INIT_PNG | IMG_INIT_JPG);
 	gApp.window = SDL_CreateWindow("Fundamentals 2 Framework", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, 0);
-	gApp.renderer = SDL_CreateRenderer(gApp.window, -1, 0);
+	gApp.renderer = SDL_CreateRenderer(gApp.window, -1, headless ? SDL_RENDERER_SOFTWARE : 0);
 
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
-	ImGui::StyleColorsDark();
-	ImGui_ImplSDL2_InitForSDLRenderer(gApp.window, gApp.renderer);
-	ImGui_ImplSDLRenderer_Init(gApp.renderer);
+	if (!headless)
+	{
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		ImGui::StyleColorsDark();
+		ImGui_ImplSDL2_InitForSDLRenderer(gApp.window, gApp.renderer);
+		ImGui_ImplSDLRenderer_Init(gApp.renderer);
+	}
 
 	gTime.previous = TotalTime();
 	gApp.running = true;
@@ -67,9 +416,24 @@ void AppExit()
 	assert(gApp.window != nullptr);
 	assert(gApp.renderer != nullptr);
 
-	ImGui_ImplSDLRenderer_Shutdown();
-	ImGui_ImplSDL2_Shutdown();
-	ImGui::DestroyContext();
+	if (!gApp.headless)
+	{
+		ImGui_ImplSDLRenderer_Shutdown();
+		ImGui_ImplSDL2_Shutdown();
+		ImGui::DestroyContext();
+	}
+
+	StopLoads();
+	StopSaves();
+	StopXmlBatches();
+	UnloadAtlas();
+	ProfilerShutdown();
+
+	// Free any textures that scenes didn't unload before the renderer that owns them is destroyed
+	for (auto& entry : gTextures.entries)
+		SDL_DestroyTexture(entry.second.texture);
+	gTextures.entries.clear();
+	gTextures.paths.clear();
 
 	SDL_DestroyRenderer(gApp.renderer);
 	SDL_DestroyWindow(gApp.window);
@@ -85,12 +449,20 @@ void PollEvents()
 	SDL_Event event;
 	while (SDL_PollEvent(&event))
 	{
-		ImGui_ImplSDL2_ProcessEvent(&event);
+		if (!gApp.headless)
+			ImGui_ImplSDL2_ProcessEvent(&event);
 		switch (event.type)
 		{
 		case SDL_QUIT:
 			gApp.running = false;
 			break;
+
+		case SDL_KEYDOWN:
+			if (event.key.keysym.scancode == SDL_SCANCODE_F1 && event.key.repeat == 0)
+				ProfilerToggle();
+			if (event.key.keysym.scancode == SDL_SCANCODE_F2 && event.key.repeat == 0)
+				ProfileCapture(300, "trace.json");
+			break;
 		}
 	}
 
@@ -98,69 +470,405 @@ void PollEvents()
 	SDL_GetMouseState(&mx, &my);
 	gApp.mousePosition = { (float)mx, (float)my };
 
-	memcpy(gApp.keyboardPrevious.data(), gApp.keyboardCurrent.data(), SDL_NUM_SCANCODES);
+	// Previous keyboard state is updated per tick rather than per frame so key presses aren't lost on frames without a tick
 	memcpy(gApp.keyboardCurrent.data(), SDL_GetKeyboardState(nullptr), SDL_NUM_SCANCODES);
 	if (IsKeyDown(SDL_SCANCODE_ESCAPE)) gApp.running = false;
 }
 
+// Records the current frame time and updates the smoothed average every samplesCount frames
+void SampleFrame()
+{
+	array<double, 10>& samples = gTime.samples;
+	samples[gTime.frameCount % samples.size()] = gTime.frame;
+	if (gTime.frameCount % samples.size() == 0)
+	{
+		double smooth = 0.0;
+		for (double sample : samples)
+			smooth += sample;
+		smooth /= (double)samples.size();
+		gTime.smooth = smooth;
+	}
+}
+
 void RenderBegin()
 {
 	gTime.current = TotalTime();
 	gTime.update = gTime.current - gTime.previous;
 	gTime.previous = gTime.current;
 
+	FinishLoads();
 	SDL_SetRenderDrawColor(gApp.renderer, 0, 0, 0, 255);
 	SDL_RenderClear(gApp.renderer);
+	gBatch.drawCalls = 0;
 }
 
 void RenderEnd()
 {
-	ImGui_ImplSDLRenderer_NewFrame();
-	ImGui_ImplSDL2_NewFrame();
-	ImGui::NewFrame();
-	//ImGui::ShowDemoWindow();
-	if (gApp.guiCallback != nullptr) gApp.guiCallback(gApp.guiData);
-	ImGui::Render();
-	ImGui_ImplSDLRenderer_RenderDrawData(ImGui::GetDrawData());
+	FlushBatch();	// Scene sprites must be drawn before the gui
+
+	{
+		PROFILE_SCOPE("ImGui");
+		ImGui_ImplSDLRenderer_NewFrame();
+		ImGui_ImplSDL2_NewFrame();
+		ImGui::NewFrame();
+		//ImGui::ShowDemoWindow();
+		if (gApp.guiCallback != nullptr) gApp.guiCallback(gApp.guiData);
+		ProfilerGui();
+		ImGui::Render();
+		ImGui_ImplSDLRenderer_RenderDrawData(ImGui::GetDrawData());
+	}
 
 	gTime.current = TotalTime();
 	gTime.render = gTime.current - gTime.previous;
 	gTime.previous = gTime.current;
 
 	gTime.frame = gTime.update + gTime.render;
+	gTime.error = 0.0;
 	if (gTime.frame < gTime.target)
 	{
 		const double waitTime = gTime.target - gTime.frame;
+		PROFILE_SCOPE("Wait");
 		Wait(waitTime);
-		gTime.frame += waitTime;
-		gTime.current = gTime.previous = TotalTime();
+		gTime.current = TotalTime();
+		gTime.error = (gTime.current - gTime.previous) - waitTime;
+		gTime.frame += gTime.current - gTime.previous;
+		gTime.previous = gTime.current;
 	}
 
-	array<double, 10>& samples = gTime.samples;
-	samples[gTime.frameCount % samples.size()] = gTime.frame;
-	if (gTime.frameCount % samples.size() == 0)
-	{
-		double smooth = 0.0;
-		for (double sample : samples)
-			smooth += sample;
-		smooth /= (double)samples.size();
-		gTime.smooth = smooth;
-	}
+	SampleFrame();
+	gTime.accumulator += gTime.frame;
+	gTime.ticks = 0;
 
+	ProfileBegin("Present");
 	SDL_RenderPresent(gApp.renderer);	// Display result of render (after wait)
+	ProfileEnd();
+
+	ProfileBegin("Events");
 	PollEvents();						// Update events before next frame
+	ProfileEnd();
+
+	ProfileFrame();
 	gTime.frameCount++;					// Finally, increment frame counter
 }
 
+void SimulateEnd()
+{
+	// No render, wait or present; the frame is however long the update took
+	gTime.current = TotalTime();
+	gTime.update = gTime.frame = gTime.current - gTime.previous;
+	gTime.render = gTime.error = 0.0;
+	gTime.previous = gTime.current;
+
+	SampleFrame();
+	memcpy(gApp.keyboardPrevious.data(), gApp.keyboardCurrent.data(), SDL_NUM_SCANCODES);
+	FinishLoads();
+	PollEvents();
+	ProfileFrame();
+	gTime.frameCount++;
+}
+
+bool Tick()
+{
+	// The previous tick has seen this input, so key presses shouldn't be reported again
+	if (gTime.ticking)
+	{
+		memcpy(gApp.keyboardPrevious.data(), gApp.keyboardCurrent.data(), SDL_NUM_SCANCODES);
+		gTime.ticking = false;
+	}
+
+	if (gTime.accumulator < gTime.tick) return false;
+
+	// Too far behind to catch up, so drop the excess (simulation slows down rather than stalling rendering)
+	if (gTime.ticks >= gTime.maxTicks)
+	{
+		gTime.accumulator = fmod(gTime.accumulator, gTime.tick);
+		return false;
+	}
+
+	gTime.accumulator -= gTime.tick;
+	gTime.ticks++;
+	gTime.ticking = true;
+	return true;
+}
+
+float TickTime()
+{
+	return gTime.tick;
+}
+
+float TickAlpha()
+{
+	return Clamp(gTime.accumulator / gTime.tick, 0.0f, 1.0f);
+}
+
+void SetTickRate(int hz)
+{
+	gTime.tick = 1.0 / (double)hz;
+}
+
+void SetMaxTicks(int ticks)
+{
+	gTime.maxTicks = ticks;
+}
+
 Texture* LoadTexture(const char* path)
 {
-	Texture* texture = IMG_LoadTexture(gApp.renderer, path);
-	return texture;
+	// Only decode an image the first time its path is requested, otherwise share the existing texture
+	TextureCache::Entry& entry = gTextures.entries[path];
+	if (entry.texture == nullptr)
+	{
+		entry.texture = IMG_LoadTexture(gApp.renderer, path);
+		if (entry.texture == nullptr)
+		{
+			gTextures.entries.erase(path);
+			return nullptr;
+		}
+		gTextures.paths[entry.texture] = path;
+	}
+
+	entry.references++;
+	return entry.texture;
 }
 
 void UnloadTexture(Texture* texture)
 {
+	auto path = gTextures.paths.find(texture);
+	if (path == gTextures.paths.end()) return;
+
+	// Destroy the texture once the last user unloads it
+	auto entry = gTextures.entries.find(path->second);
+	if (--entry->second.references > 0) return;
+
+	if (texture == gBatch.texture)
+	{
+		FlushBatch();
+		gBatch.texture = nullptr;
+	}
 	SDL_DestroyTexture(texture);
+	gTextures.entries.erase(entry);
+	gTextures.paths.erase(path);
+}
+
+void LoadAtlas(const vector<const char*>& paths, int pageSize)
+{
+	assert(gAtlas.pages.empty());
+	const int padding = 1;	// Transparent border so neighbouring images don't bleed into each other
+
+	SDL_RendererInfo info;
+	SDL_GetRendererInfo(gApp.renderer, &info);
+	if (info.max_texture_width > 0) pageSize = min(pageSize, info.max_texture_width);
+	if (info.max_texture_height > 0) pageSize = min(pageSize, info.max_texture_height);
+
+	// Decode every image up-front so the packer knows their sizes
+	vector<SDL_Surface*> images(paths.size(), nullptr);
+	vector<stbrp_rect> remaining;
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		SDL_Surface* image = IMG_Load(paths[i]);
+		if (image == nullptr) continue;
+		images[i] = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(image);
+		if (images[i] == nullptr) continue;
+
+		stbrp_rect rect{};
+		rect.id = (int)i;
+		rect.w = images[i]->w + padding * 2;
+		rect.h = images[i]->h + padding * 2;
+		remaining.push_back(rect);
+	}
+
+	// Fill pages until every image is packed. Images larger than a page are left for LoadSprite to load on their own
+	vector<stbrp_node> nodes(pageSize);
+	while (!remaining.empty())
+	{
+		stbrp_rect white{};
+		white.id = -1;
+		white.w = white.h = 1 + padding * 2;
+		remaining.insert(remaining.begin(), white);
+
+		stbrp_context context;
+		stbrp_init_target(&context, pageSize, pageSize, nodes.data(), (int)nodes.size());
+		stbrp_pack_rects(&context, remaining.data(), (int)remaining.size());
+
+		auto unpacked = stable_partition(remaining.begin(), remaining.end(), [](const stbrp_rect& rect) { return rect.was_packed; });
+		if (unpacked - remaining.begin() <= 1) break;	// Nothing fits besides the white pixel
+
+		SDL_Surface* page = SDL_CreateRGBSurfaceWithFormat(0, pageSize, pageSize, 32, SDL_PIXELFORMAT_RGBA32);
+		SDL_Rect whiteRect{};
+		vector<int> packed;
+		for (auto rect = remaining.begin(); rect != unpacked; rect++)
+		{
+			SDL_Rect destination{ rect->x + padding, rect->y + padding, rect->w - padding * 2, rect->h - padding * 2 };
+			if (rect->id < 0)
+			{
+				whiteRect = destination;
+				SDL_FillRect(page, &destination, SDL_MapRGBA(page->format, 255, 255, 255, 255));
+			}
+			else
+			{
+				SDL_SetSurfaceBlendMode(images[rect->id], SDL_BLENDMODE_NONE);
+				SDL_BlitSurface(images[rect->id], nullptr, page, &destination);
+				gAtlas.sprites[paths[rect->id]].source = destination;
+				packed.push_back(rect->id);
+			}
+		}
+
+		Texture* texture = SDL_CreateTextureFromSurface(gApp.renderer, page);
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		SDL_FreeSurface(page);
+
+		for (int id : packed)
+			gAtlas.sprites[paths[id]].texture = texture;
+		gAtlas.whites[texture] = whiteRect;
+		gAtlas.pages.push_back(texture);
+		remaining.erase(remaining.begin(), unpacked);
+	}
+
+	for (SDL_Surface* image : images)
+		SDL_FreeSurface(image);
+}
+
+void UnloadAtlas()
+{
+	FlushBatch();
+	gBatch.texture = nullptr;
+
+	for (Texture* page : gAtlas.pages)
+		SDL_DestroyTexture(page);
+	gAtlas.pages.clear();
+	gAtlas.sprites.clear();
+	gAtlas.whites.clear();
+}
+
+Sprite LoadSprite(const char* path)
+{
+	auto sprite = gAtlas.sprites.find(path);
+	if (sprite != gAtlas.sprites.end())
+		return sprite->second;
+
+	// Not in the atlas, so use the whole of a standalone texture
+	Sprite result;
+	result.texture = LoadTexture(path);
+	if (result.texture != nullptr)
+		SDL_QueryTexture(result.texture, nullptr, nullptr, &result.source.w, &result.source.h);
+	return result;
+}
+
+void UnloadSprite(const Sprite& sprite)
+{
+	// Atlas pages are owned by the atlas
+	if (gAtlas.whites.find(sprite.texture) == gAtlas.whites.end())
+		UnloadTexture(sprite.texture);
+}
+
+Handle LoadTextureAsync(const char* path)
+{
+	// Already cached, so there's nothing to load
+	auto entry = gTextures.entries.find(path);
+	if (entry == gTextures.entries.end())
+		return QueueLoad(ASSET_TEXTURE, path);
+
+	if (gAssets.assets.Full())
+		gAssets.assets.Reserve(max<size_t>(gAssets.assets.Capacity() * 2, 64));
+
+	AssetLoader::Asset asset;
+	asset.type = ASSET_TEXTURE;
+	asset.loading = false;
+	asset.data = entry->second.texture;
+	entry->second.references++;
+	return gAssets.assets.Add(asset);
+}
+
+Handle LoadSoundAsync(const char* path)
+{
+	return QueueLoad(ASSET_SOUND, path);
+}
+
+Handle LoadMusicAsync(const char* path)
+{
+	return QueueLoad(ASSET_MUSIC, path);
+}
+
+Texture* GetTexture(Handle asset)
+{
+	const AssetLoader::Asset* result = gAssets.assets.Get(asset);
+	return result != nullptr && result->type == ASSET_TEXTURE ? (Texture*)result->data : nullptr;
+}
+
+Sound* GetSound(Handle asset)
+{
+	const AssetLoader::Asset* result = gAssets.assets.Get(asset);
+	return result != nullptr && result->type == ASSET_SOUND ? (Sound*)result->data : nullptr;
+}
+
+Music* GetMusic(Handle asset)
+{
+	const AssetLoader::Asset* result = gAssets.assets.Get(asset);
+	return result != nullptr && result->type == ASSET_MUSIC ? (Music*)result->data : nullptr;
+}
+
+bool IsLoading(Handle asset)
+{
+	const AssetLoader::Asset* result = gAssets.assets.Get(asset);
+	return result != nullptr && result->loading;
+}
+
+void UnloadAsset(Handle asset)
+{
+	AssetLoader::Asset* result = gAssets.assets.Get(asset);
+	if (result == nullptr) return;
+
+	// Still loading assets are discarded by FinishLoads once their handle is gone
+	if (result->data != nullptr)
+	{
+		switch (result->type)
+		{
+		case ASSET_TEXTURE:
+			UnloadTexture((Texture*)result->data);
+			break;
+
+		case ASSET_SOUND:
+			UnloadSound((Sound*)result->data);
+			break;
+
+		case ASSET_MUSIC:
+			UnloadMusic((Music*)result->data);
+			break;
+		}
+	}
+	gAssets.assets.Remove(asset);
+}
+
+Texture* CreateRenderTarget(int width, int height)
+{
+	Texture* target = SDL_CreateTexture(gApp.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+	if (target != nullptr)
+		SDL_SetTextureBlendMode(target, SDL_BLENDMODE_BLEND);
+	return target;
+}
+
+void DestroyRenderTarget(Texture* target)
+{
+	if (target == gBatch.texture)
+	{
+		FlushBatch();
+		gBatch.texture = nullptr;
+	}
+	SDL_DestroyTexture(target);
+}
+
+void SetRenderTarget(Texture* target)
+{
+	FlushBatch();	// Queued quads belong to the previous target
+	SDL_SetRenderTarget(gApp.renderer, target);
+	if (target == nullptr) return;
+
+	// Start from transparent so nothing from the last capture (or uninitialized memory) shows through
+	Uint8 r, g, b, a;
+	SDL_GetRenderDrawColor(gApp.renderer, &r, &g, &b, &a);
+	SDL_SetRenderDrawColor(gApp.renderer, 0, 0, 0, 0);
+	SDL_RenderClear(gApp.renderer);
+	SDL_SetRenderDrawColor(gApp.renderer, r, g, b, a);
 }
 
 void Tint(Texture* texture, const Color& color)
@@ -171,6 +879,8 @@ void Tint(Texture* texture, const Color& color)
 
 void BlendMode(SDL_BlendMode mode)
 {
+	FlushBatch();	// Queued quads were drawn under the previous blend mode
+	gApp.blendMode = mode;
 	SDL_SetRenderDrawBlendMode(gApp.renderer, mode);
 }
 
@@ -186,6 +896,7 @@ void UnloadSound(Sound* sound)
 
 void PlaySound(Sound* sound, bool loop)
 {
+	if (sound == nullptr) return;
 	Mix_PlayChannel(-1, sound, loop ? -1 : 0);
 }
 
@@ -201,6 +912,7 @@ void UnloadMusic(Music* music)
 
 void PlayMusic(Music* music, bool loop)
 {
+	if (music == nullptr) return;
 	Mix_PlayMusic(music, loop ? -1 : 0);
 }
 
@@ -235,14 +947,25 @@ float FrameTimeSmoothed()
 	return gTime.smooth;
 }
 
+float PacingError()
+{
+	return gTime.error;
+}
+
 double TotalTime()
 {
-	return SDL_GetTicks64() / 1000.0;
+	return (SDL_GetPerformanceCounter() - gTime.start) / gTime.frequency;
 }
 
 void Wait(double seconds)
 {
 	double destinationTime = TotalTime() + seconds;
+
+	// Sleep through most of the wait so we don't burn a core, then spin for the remainder since sleep can overshoot
+	double sleepTime = seconds - gTime.sleepMargin;
+	if (sleepTime >= 0.001)
+		SDL_Delay((Uint32)(sleepTime * 1000.0));
+
 	while (TotalTime() < destinationTime) {}
 }
 
@@ -251,6 +974,11 @@ bool IsRunning()
 	return gApp.running;
 }
 
+bool IsHeadless()
+{
+	return gApp.headless;
+}
+
 bool IsKeyDown(SDL_Scancode key)
 {
 	return gApp.keyboardCurrent[key] == 1;
@@ -266,19 +994,42 @@ Point MousePosition()
 	return gApp.mousePosition;
 }
 
+size_t DrawCalls()
+{
+	return gBatch.drawCalls;
+}
+
 void DrawLine(const Point& start, const Point& end, const Color& color)
 {
-	SDL_SetRenderDrawColor(gApp.renderer, color.r, color.g, color.b, color.a);
-	SDL_RenderDrawLineF(gApp.renderer, start.x, start.y, end.x, end.y);
+	// Lines are 1 pixel wide quads so they can share a batch with rects
+	Point normal = Normalize({ start.y - end.y, end.x - start.x }) * 0.5f;
+	BatchSolid({ start + normal, end + normal, end - normal, start - normal }, color);
 }
 
 void DrawRect(const Rect& rect, const Color& color)
 {
-	SDL_SetRenderDrawColor(gApp.renderer, color.r, color.g, color.b, color.a);
-	SDL_RenderFillRectF(gApp.renderer, &rect);
+	BatchSolid({
+		Point{ rect.x, rect.y },
+		Point{ rect.x + rect.w, rect.y },
+		Point{ rect.x + rect.w, rect.y + rect.h },
+		Point{ rect.x, rect.y + rect.h } }, color);
 }
 
 void DrawTexture(Texture* texture, const Rect& rect, float degrees)
 {
-	SDL_RenderCopyExF(gApp.renderer, texture, nullptr, &rect, degrees, nullptr, SDL_FLIP_NONE);
+	BatchSprite(texture, { 0.0f, 0.0f }, { 1.0f, 1.0f }, rect, degrees, { 255, 255, 255, 255 });
+}
+
+void DrawTexture(Texture* texture, const SDL_Rect& source, const Rect& rect, float degrees, const Color& tint)
+{
+	int w, h;
+	if (texture == nullptr || SDL_QueryTexture(texture, nullptr, nullptr, &w, &h) != 0) return;
+	Point uvMin{ source.x / (float)w, source.y / (float)h };
+	Point uvMax{ (source.x + source.w) / (float)w, (source.y + source.h) / (float)h };
+	BatchSprite(texture, uvMin, uvMax, rect, degrees, tint);
+}
+
+void DrawSprite(const Sprite& sprite, const Rect& rect, float degrees, const Color& tint)
+{
+	DrawTexture(sprite.texture, sprite.source, rect, degrees, tint);
 }
@@ -4,6 +4,10 @@
 #include <SDL_mixer.h>
 #include "imgui/imgui.h"
 #include "Math.h"
+#include "Profiler.h"
+#include "Pool.h"
+#include "SaveQueue.h"
+#include <vector>
 
 using Texture = SDL_Texture;
 using Color = SDL_Color;
@@ -11,16 +15,44 @@ using Sound = Mix_Chunk;
 using Music = Mix_Music;
 using GuiCallback = void(*)(void*);
 
+// Region of a (possibly shared) texture
+struct Sprite
+{
+	Texture* texture = nullptr;
+	SDL_Rect source{};
+};
+
 void SetGuiCallback(GuiCallback callback, void* data);
 
-void AppInit(int width, int height);
+void AppInit(int width, int height, bool headless = false);	// Headless uses dummy video & audio drivers and no gui
 void AppExit();
 
 void RenderBegin();
 void RenderEnd();
+void SimulateEnd();	// Headless replacement for RenderBegin & RenderEnd (frame timing & events only, no frame limit)
+
+Texture* LoadTexture(const char* path);	// Shared & reference-counted per path
+void UnloadTexture(Texture* texture);		// Destroys texture once all loads are unloaded
+void LoadAtlas(const std::vector<const char*>& paths, int pageSize = 2048);	// Packs images into as few textures as possible
+void UnloadAtlas();
+Sprite LoadSprite(const char* path);		// Atlas region if packed, otherwise the whole of a standalone texture
+void UnloadSprite(const Sprite& sprite);
+
+// Asynchronous loading. Files are read & decoded on worker threads, then finished on the main thread at the start
+// of each frame. Handles are valid immediately but resolve to nullptr until loading finishes (or if it failed).
+Handle LoadTextureAsync(const char* path);	// Shares the texture cache with LoadTexture
+Handle LoadSoundAsync(const char* path);
+Handle LoadMusicAsync(const char* path);
+Texture* GetTexture(Handle asset);
+Sound* GetSound(Handle asset);
+Music* GetMusic(Handle asset);
+bool IsLoading(Handle asset);
+void UnloadAsset(Handle asset);	// Cancels the load if it hasn't finished
+
+Texture* CreateRenderTarget(int width, int height);	// Blended texture that can be drawn into with SetRenderTarget
+void DestroyRenderTarget(Texture* target);
+void SetRenderTarget(Texture* target);	// Clears target to transparent. nullptr draws to the screen again
 
-Texture* LoadTexture(const char* path);
-void UnloadTexture(Texture* texture);
 void Tint(Texture* texture, const Color& color);
 void BlendMode(SDL_BlendMode mode);
 
@@ -39,15 +71,28 @@ void SetFps(int fps);	// Desired (maximum) frame rate
 
 float FrameTime();			// Time duration for frame update + frame render
 float FrameTimeSmoothed();	// Time duration for frame update + frame render over 10 frames
+float PacingError();		// Seconds the last frame-limiting wait overshot (+) or undershot (-) its target
+
+// Fixed timestep: call Scene::Update(TickTime()) while Tick() returns true, then render with TickAlpha()
+bool Tick();				// Whether there's enough accumulated frame time to run another tick this frame
+float TickTime();			// Seconds simulated per tick
+float TickAlpha();			// Fraction of a tick between the last tick and now, for interpolating previous & current state
+void SetTickRate(int hz);	// Desired simulation rate (independent of frame rate)
+void SetMaxTicks(int ticks);// Most ticks run per frame to catch up after a slow frame
 
 double TotalTime();			// Time since program start in seconds
-void Wait(double seconds);	// Halts the program for seconds
+void Wait(double seconds);	// Halts the program for seconds (sleeps, then spins for sub-millisecond accuracy)
 
 bool IsRunning();
+bool IsHeadless();
 bool IsKeyDown(SDL_Scancode key);
 bool IsKeyPressed(SDL_Scancode key);
 Point MousePosition();
 
+size_t DrawCalls();	// Number of batched draw calls submitted this frame
+
 void DrawLine(const Point& start, const Point& end, const Color& color);
 void DrawRect(const Rect& rect, const Color& color);
-void DrawTexture(Texture* texture, const Rect& rect, float degrees = 0.0f);
\ No newline at end of file
+void DrawTexture(Texture* texture, const Rect& rect, float degrees = 0.0f);
+void DrawTexture(Texture* texture, const SDL_Rect& source, const Rect& rect, float degrees = 0.0f, const Color& tint = { 255, 255, 255, 255 });
+void DrawSprite(const Sprite& sprite, const Rect& rect, float degrees = 0.0f, const Color& tint = { 255, 255, 255, 255 });
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "Fields.h"
+#include "Snapshot.h"
+#include "tinyxml2.h"
+#include <cstring>
+#include <string>
+
+using namespace std;
+using namespace tinyxml2;
+
+static float& FloatAt(void* object, const Field& field)
+{
+	return *reinterpret_cast<float*>(static_cast<char*>(object) + field.offset);
+}
+
+static int& IntAt(void* object, const Field& field)
+{
+	return *reinterpret_cast<int*>(static_cast<char*>(object) + field.offset);
+}
+
+static float FloatAt(const void* object, const Field& field)
+{
+	return *reinterpret_cast<const float*>(static_cast<const char*>(object) + field.offset);
+}
+
+static int IntAt(const void* object, const Field& field)
+{
+	return *reinterpret_cast<const int*>(static_cast<const char*>(object) + field.offset);
+}
+
+// Length of the first name in a path such as "Wheel/Radius"
+static size_t SegmentLength(const char* path)
+{
+	const char* end = strchr(path, '/');
+	return end != nullptr ? end - path : strlen(path);
+}
+
+static bool SegmentEqual(const char* name, const char* path, size_t length)
+{
+	return strncmp(name, path, length) == 0 && name[length] == '\0';
+}
+
+static const XMLElement* FindElement(const XMLElement& root, const char* path)
+{
+	const XMLElement* element = &root;
+	while (element != nullptr && path != nullptr && *path != '\0')
+	{
+		const size_t length = SegmentLength(path);
+		const XMLElement* child = element->FirstChildElement();
+		while (child != nullptr && !SegmentEqual(child->Name(), path, length))
+			child = child->NextSiblingElement();
+		element = child;
+		path = path[length] == '/' ? path + length + 1 : nullptr;
+	}
+	return element;
+}
+
+static XMLElement* MakeElement(XMLElement& root, const char* path)
+{
+	XMLElement* element = &root;
+	while (path != nullptr && *path != '\0')
+	{
+		const size_t length = SegmentLength(path);
+		XMLElement* child = element->FirstChildElement();
+		while (child != nullptr && !SegmentEqual(child->Name(), path, length))
+			child = child->NextSiblingElement();
+		if (child == nullptr)
+		{
+			child = element->GetDocument()->NewElement(string(path, length).c_str());
+			element->InsertEndChild(child);
+		}
+		element = child;
+		path = path[length] == '/' ? path + length + 1 : nullptr;
+	}
+	return element;
+}
+
+// Number of fields from first that share its element
+static size_t GroupSize(const Field* first, size_t remaining)
+{
+	size_t size = 1;
+	while (size < remaining && SameName(first[size].element, first->element))
+		size++;
+	return size;
+}
+
+// Matches an attribute to one of a group's fields by hash, confirming with a single compare
+static const Field* FindField(const Field* group, size_t size, const char* name)
+{
+	const Uint32 hash = HashName(name);
+	for (size_t i = 0; i < size; i++)
+	{
+		if (group[i].hash == hash)
+			return strcmp(group[i].name, name) == 0 ? &group[i] : nullptr;
+	}
+	return nullptr;
+}
+
+static void ReadAttribute(const Field& field, const char* value, void* object)
+{
+	if (field.type == FIELD_FLOAT)
+		XMLUtil::ToFloat(value, &FloatAt(object, field));
+	else
+		XMLUtil::ToInt(value, &IntAt(object, field));
+}
+
+bool LoadFields(const XMLElement& root, const Field* fields, size_t count, void* object)
+{
+	bool found = true;
+	for (size_t i = 0; i < count;)
+	{
+		const size_t size = GroupSize(fields + i, count - i);
+		const XMLElement* element = FindElement(root, fields[i].element);
+		if (element != nullptr)
+		{
+			for (const XMLAttribute* attribute = element->FirstAttribute(); attribute != nullptr; attribute = attribute->Next())
+			{
+				const Field* field = FindField(fields + i, size, attribute->Name());
+				if (field != nullptr)
+					ReadAttribute(*field, attribute->Value(), object);
+			}
+		}
+		found = found && element != nullptr;
+		i += size;
+	}
+	return found;
+}
+
+bool LoadFields(const XMLStreamReader& reader, const Field* fields, size_t count, void* object)
+{
+	// The reader only sees the current element, so only fields stored on it apply
+	const size_t size = count > 0 && fields->element == nullptr ? GroupSize(fields, count) : 0;
+	for (int i = 0; i < reader.AttributeCount(); i++)
+	{
+		const Field* field = FindField(fields, size, reader.AttributeName(i));
+		if (field != nullptr)
+			ReadAttribute(*field, reader.AttributeValue(i), object);
+	}
+	return size == count;
+}
+
+void SaveFields(XMLElement& root, const Field* fields, size_t count, const void* object)
+{
+	for (size_t i = 0; i < count;)
+	{
+		const size_t size = GroupSize(fields + i, count - i);
+		XMLElement* element = MakeElement(root, fields[i].element);
+		for (size_t j = i; j < i + size; j++)
+		{
+			if (fields[j].type == FIELD_FLOAT)
+				element->SetAttribute(fields[j].name, FloatAt(object, fields[j]));
+			else
+				element->SetAttribute(fields[j].name, IntAt(object, fields[j]));
+		}
+		i += size;
+	}
+}
+
+void WriteFields(SnapshotWriter& writer, const Field* fields, size_t count, const void* object)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (fields[i].type == FIELD_FLOAT)
+			writer.Write(FloatAt(object, fields[i]));
+		else
+			writer.Write((Sint32)IntAt(object, fields[i]));
+	}
+}
+
+bool ReadFields(SnapshotReader& reader, const Field* fields, size_t count, void* object)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		Sint32 value = 0;
+		if (fields[i].type == FIELD_FLOAT)
+			reader.Read(FloatAt(object, fields[i]));
+		else if (reader.Read(value))
+			IntAt(object, fields[i]) = value;
+	}
+	return reader.Ok();
+}
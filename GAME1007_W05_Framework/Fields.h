@@ -0,0 +1,120 @@
+#pragma once
+#include <SDL.h>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Describes a struct's fields once so the same description reads & writes it as XML attributes and as a binary snapshot.
+// Each field is a float or int at a fixed offset, stored as attribute name on element, where element is a child path
+// such as "Wheel/Radius" (or nullptr for the element being read or written itself). Snapshots store fields in order.
+//
+//	constexpr Field GAME_FIELDS[] = {
+//		FIELD(GameSave, "Ship", "x", ship.x),
+//		FIELD(GameSave, "Ship", "speed", speed),
+//	};
+//	static_assert(ValidFields(GAME_FIELDS), "...");
+//
+// Names are hashed at compile time, so reading matches each attribute by hash instead of comparing it to every name.
+
+namespace tinyxml2
+{
+	class XMLElement;
+	class XMLStreamReader;
+}
+class SnapshotWriter;
+class SnapshotReader;
+
+enum FieldType : Uint8
+{
+	FIELD_FLOAT,
+	FIELD_INT
+};
+
+// FNV-1a
+constexpr Uint32 HashName(const char* name)
+{
+	Uint32 hash = 2166136261u;
+	for (; *name != '\0'; name++)
+		hash = (hash ^ (Uint8)*name) * 16777619u;
+	return hash;
+}
+
+struct Field
+{
+	const char* element;
+	const char* name;
+	FieldType type;
+	size_t offset;
+	Uint32 hash;
+};
+
+template<typename T>
+constexpr FieldType FieldTypeOf()
+{
+	static_assert(std::is_same<T, float>::value || std::is_same<T, int>::value, "Fields must be float or int");
+	return std::is_same<T, float>::value ? FIELD_FLOAT : FIELD_INT;
+}
+
+#define FIELD(Struct, element, name, member) Field{ element, name,\
+	FieldTypeOf<std::remove_reference_t<decltype(std::declval<Struct&>().member)>>(), offsetof(Struct, member), HashName(name) }
+
+constexpr bool SameName(const char* a, const char* b)
+{
+	if (a == nullptr || b == nullptr) return a == b;
+	for (; *a != '\0' && *a == *b; a++, b++);
+	return *a == *b;
+}
+
+// Fields on the same element must be listed together, and no two may share an attribute name (or its hash)
+template<size_t N>
+constexpr bool ValidFields(const Field (&fields)[N])
+{
+	for (size_t i = 0; i < N; i++)
+	{
+		for (size_t j = i + 1; j < N; j++)
+		{
+			if (!SameName(fields[i].element, fields[j].element)) continue;
+			if (fields[i].hash == fields[j].hash) return false;
+			if (!SameName(fields[i].element, fields[j - 1].element)) return false;
+		}
+	}
+	return true;
+}
+
+// All fields are 4 bytes in a snapshot
+template<size_t N>
+constexpr size_t FieldsSize(const Field (&)[N])
+{
+	return N * 4;
+}
+
+// Reading leaves fields whose attributes are missing unchanged, and returns false if an element is missing
+bool LoadFields(const tinyxml2::XMLElement& root, const Field* fields, size_t count, void* object);
+bool LoadFields(const tinyxml2::XMLStreamReader& reader, const Field* fields, size_t count, void* object);	// The current element
+void SaveFields(tinyxml2::XMLElement& root, const Field* fields, size_t count, const void* object);
+void WriteFields(SnapshotWriter& writer, const Field* fields, size_t count, const void* object);
+bool ReadFields(SnapshotReader& reader, const Field* fields, size_t count, void* object);
+
+template<typename Source, typename T, size_t N>
+bool LoadFields(const Source& source, const Field (&fields)[N], T& object)
+{
+	return LoadFields(source, fields, N, &object);
+}
+
+template<typename T, size_t N>
+void SaveFields(tinyxml2::XMLElement& root, const Field (&fields)[N], const T& object)
+{
+	SaveFields(root, fields, N, &object);
+}
+
+template<typename T, size_t N>
+void WriteFields(SnapshotWriter& writer, const Field (&fields)[N], const T& object)
+{
+	WriteFields(writer, fields, N, &object);
+}
+
+template<typename T, size_t N>
+bool ReadFields(SnapshotReader& reader, const Field (&fields)[N], T& object)
+{
+	return ReadFields(reader, fields, N, &object);
+}
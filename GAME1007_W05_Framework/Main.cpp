@@ -1,9 +1,17 @@
 #include <SDL_main.h>
 #include "Core.h"
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <random>
+#include <thread>
 #include "tinyxml2.h"
 #include "Scene.h"
+#include "Fields.h"
+#include "Saves.h"
+#include "XmlBatch.h"
 using namespace tinyxml2;
 using namespace std;
 
@@ -27,25 +35,24 @@ struct Car
 	float mass;
 };
 
+constexpr Field CAR_FIELDS[] = {
+	FIELD(Car, "Acceleration", "a", acceleration),
+	FIELD(Car, "Wheel/Radius", "r", wheel.radius),
+	FIELD(Car, "Mass", "m", mass),
+};
+static_assert(ValidFields(CAR_FIELDS), "Car fields must be grouped by element with unique names");
+
 void SaveCar()
 {
+	Car car;
+	car.acceleration = 20.0f;
+	car.wheel.radius = 10.0f;
+	car.mass = 30.0f;
+
 	XMLDocument doc;	//DOM tree (in-memory representation of xml document)
-	XMLNode* root = doc.NewElement("CarDefinition");
+	XMLElement* root = doc.NewElement("CarDefinition");
 	doc.InsertEndChild(root);
-
-	XMLElement* acceleration = doc.NewElement("Acceleration");
-	acceleration->SetAttribute("a", 20.0f);
-	root->InsertEndChild(acceleration);
-
-	XMLElement* wheel = doc.NewElement("Wheel");
-	XMLElement* radius = doc.NewElement("Radius");
-	radius->SetAttribute("r", 10.0f);
-	wheel->InsertEndChild(radius);
-	root->InsertEndChild(wheel);
-
-	XMLElement* mass = doc.NewElement("Mass");
-	mass->SetAttribute("m", 30.0f);
-	root->InsertEndChild(mass);
+	SaveFields(*root, CAR_FIELDS, car);
 
 	doc.SaveFile("Car.xml");
 }
@@ -55,64 +62,30 @@ void LoadCar(Car& car)
 	XMLDocument doc;
 	doc.LoadFile("Car.xml");
 
-	// CarDefinition is doc.FirstChildElement(),
-	// so doc.FirstChildElement()->FirstChildElement() is Acceleration.
-	XMLElement* element = doc.FirstChildElement()->FirstChildElement();
-
-	while (element != nullptr)
-	{
-		cout << "Current element: " << element->Value() << endl;
-
-		if (strcmp(element->Value(), "Mass") == 0)
-		{
-			element->QueryAttribute("m", &car.mass);
-		}
-
-		if (strcmp(element->Value(), "Acceleration") == 0)
-		{
-			element->QueryAttribute("a", &car.acceleration);
-		}
-
-		if (strcmp(element->Value(), "Wheel") == 0)
-		{
-			element->FirstChildElement()->QueryAttribute("r", &car.wheel.radius);
-		}
-
-		element = element->NextSiblingElement();
-	}
+	// CarDefinition is doc.FirstChildElement(); CAR_FIELDS finds Acceleration, Wheel/Radius & Mass beneath it.
+	XMLElement* root = doc.FirstChildElement();
+	if (root != nullptr)
+		LoadFields(*root, CAR_FIELDS, car);
 }
 
 void SaveGame(const Game& game)
 {
-	XMLDocument doc;
-	XMLNode* root = doc.NewElement("Game");
-	doc.InsertEndChild(root);
-
-	XMLElement* ship = doc.NewElement("Ship");
-	ship->SetAttribute("x", game.shipRec.x);
-	ship->SetAttribute("y", game.shipRec.y);
-	ship->SetAttribute("w", game.shipRec.w);
-	ship->SetAttribute("h", game.shipRec.h);
-	ship->SetAttribute("speed", game.shipSpeed);
-	root->InsertEndChild(ship);
-
-	doc.SaveFile("Game.xml");
+	GameSave save;
+	save.ship = game.shipRec;
+	save.speed = game.shipSpeed;
+	SaveXml("Game.xml", save);
 }
 
 void LoadGame(Game& game)
 {
-	XMLDocument doc;
-	doc.LoadFile("Game.xml");
+	GameSave save;
+	save.ship = game.shipRec;
+	save.speed = game.shipSpeed;
+	if (!LoadXml("Game.xml", save)) return;
 
-	XMLElement* gameData = doc.FirstChildElement();
-	XMLElement* shipData = gameData->FirstChildElement();
-	shipData->QueryAttribute("x", &game.shipRec.x);
-	shipData->QueryAttribute("y", &game.shipRec.y);
-	shipData->QueryAttribute("w", &game.shipRec.w);
-	shipData->QueryAttribute("h", &game.shipRec.h);
-	shipData->QueryAttribute("speed", &game.shipSpeed);
-
-	cout << "Loaded " << gameData->Value() << endl;
+	game.shipRec = save.ship;
+	game.shipSpeed = save.speed;
+	cout << "Loaded Game" << endl;
 }
 
 Uint32 Pause(Uint32 interval, void* param)
@@ -155,16 +128,312 @@ void OnGui(void* data)
 	}
 }
 
+// Headless mode runs Scene::Update as fast as possible to measure simulation throughput.
+// Enable with --headless or HEADLESS=1. Optional arguments:
+//	--frames=N	quit after N frames and report frames per second
+//	--dt=S		simulate S seconds per frame instead of the measured frame time
+//	--scene=N	start in Scene::Type N (ie 7 for ASTEROIDS)
+//	--tick=HZ	simulation rate (also applies to windowed mode)
+//	--trace=N	write the first N frames to trace.json (also applies to windowed mode)
+//	--resident=N	keep at most N scenes loaded (also applies to windowed mode)
+// Tools (run instead of the game):
+//	--export=NAME	convert NAME.snap to NAME.xml for editing (NAME is Game, AstGame or Turrets)
+//	--import=NAME	convert NAME.xml back to NAME.snap
+//	--xmlbench=N	time writing & reading an XML document with N numeric attributes
+//	--xmlbatch=N	time loading N definition files with LoadXmlBatch on 1 thread up to one per core
+struct Options
+{
+	bool headless = false;
+	size_t frames = 0;
+	float dt = 0.0f;
+	int scene = -1;
+	int tick = 0;
+	size_t trace = 0;
+	size_t resident = 0;
+	const char* exportSave = nullptr;
+	const char* importSave = nullptr;
+	size_t xmlBench = 0;
+	size_t xmlBatch = 0;
+};
+
+Options ParseOptions(int argc, char* argv[])
+{
+	Options options;
+	const char* env = SDL_getenv("HEADLESS");
+	options.headless = env != nullptr && strcmp(env, "0") != 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+			options.headless = true;
+		else if (strncmp(argv[i], "--frames=", 9) == 0)
+			options.frames = strtoull(argv[i] + 9, nullptr, 10);
+		else if (strncmp(argv[i], "--dt=", 5) == 0)
+			options.dt = strtof(argv[i] + 5, nullptr);
+		else if (strncmp(argv[i], "--scene=", 8) == 0)
+			options.scene = atoi(argv[i] + 8);
+		else if (strncmp(argv[i], "--tick=", 7) == 0)
+			options.tick = atoi(argv[i] + 7);
+		else if (strncmp(argv[i], "--trace=", 8) == 0)
+			options.trace = strtoull(argv[i] + 8, nullptr, 10);
+		else if (strncmp(argv[i], "--resident=", 11) == 0)
+			options.resident = strtoull(argv[i] + 11, nullptr, 10);
+		else if (strncmp(argv[i], "--export=", 9) == 0)
+			options.exportSave = argv[i] + 9;
+		else if (strncmp(argv[i], "--import=", 9) == 0)
+			options.importSave = argv[i] + 9;
+		else if (strncmp(argv[i], "--xmlbench=", 11) == 0)
+			options.xmlBench = strtoull(argv[i] + 11, nullptr, 10);
+		else if (strncmp(argv[i], "--xmlbatch=", 11) == 0)
+			options.xmlBatch = strtoull(argv[i] + 11, nullptr, 10);
+	}
+	return options;
+}
+
+void RunHeadless(const Options& options)
+{
+	size_t frames = 0;
+	double start = TotalTime();
+	while (IsRunning() && (options.frames == 0 || frames < options.frames))
+	{
+		Scene::Update(options.dt > 0.0f ? options.dt : FrameTime());
+		SimulateEnd();
+		frames++;
+	}
+
+	double elapsed = TotalTime() - start;
+	cout << "Simulated " << frames << " frames in " << elapsed << " seconds ("
+		<< frames / elapsed << " frames per second)" << endl;
+}
+
+// Runs before AppInit, so times with the standard clock rather than TotalTime
+static double SecondsSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void ReportRate(const char* stage, size_t count, size_t bytes, double seconds)
+{
+	cout << stage << ": " << seconds * 1000.0 << " ms (" << count / seconds / 1e6 << "M attributes/s, "
+		<< bytes / seconds / (1024.0 * 1024.0) << " MB/s)" << endl;
+}
+
+// sscanf as tinyxml2 calls it (MSVC rejects plain sscanf under /sdl)
+static int ScanFloat(const char* text, float* value)
+{
+#ifdef _MSC_VER
+	return sscanf_s(text, "%f", value);
+#else
+	return sscanf(text, "%f", value);
+#endif
+}
+
+// Builds a Turrets.xml-style document of N numeric attributes (6 per <Turret>), then times serializing it,
+// parsing it & reading every attribute back. The number conversions are also timed alone against the
+// sscanf/snprintf calls tinyxml2 uses without charconv (or when built with TIXML_NO_CHARCONV).
+void RunXmlBenchmark(size_t attributes)
+{
+	const size_t turrets = (attributes + 5) / 6;
+	attributes = turrets * 6;
+
+	mt19937 rng(1007);
+	uniform_real_distribution<float> position(0.0f, 1024.0f);
+	uniform_real_distribution<float> cooldown(0.1f, 2.0f);
+	uniform_int_distribution<int> kills(0, 10000);
+
+	auto start = chrono::steady_clock::now();
+	XMLDocument doc;
+	for (size_t i = 0; i < turrets; i++)
+	{
+		XMLElement* turret = doc.NewElement("Turret");
+		turret->SetAttribute("x", position(rng));
+		turret->SetAttribute("y", position(rng));
+		turret->SetAttribute("w", 100.0f);
+		turret->SetAttribute("h", 100.0f);
+		turret->SetAttribute("kills", kills(rng));
+		turret->SetAttribute("cooldown", cooldown(rng));
+		doc.InsertEndChild(turret);
+	}
+	XMLPrinter printer;
+	doc.Print(&printer);
+	const size_t bytes = printer.CStrSize() - 1;
+	ReportRate("Serialize", attributes, bytes, SecondsSince(start));
+
+	start = chrono::steady_clock::now();
+	XMLDocument parsed;
+	if (parsed.Parse(printer.CStr(), bytes) != XML_SUCCESS)
+	{
+		cout << "Parse failed: " << parsed.ErrorStr() << endl;
+		return;
+	}
+	ReportRate("Parse", attributes, bytes, SecondsSince(start));
+
+	start = chrono::steady_clock::now();
+	vector<const char*> values;
+	values.reserve(attributes);
+	float checksum = 0.0f;
+	for (XMLElement* turret = parsed.FirstChildElement(); turret != nullptr; turret = turret->NextSiblingElement())
+	{
+		for (const XMLAttribute* attribute = turret->FirstAttribute(); attribute != nullptr; attribute = attribute->Next())
+		{
+			checksum += attribute->FloatValue();
+			values.push_back(attribute->Value());
+		}
+	}
+	ReportRate("Read attributes", attributes, bytes, SecondsSince(start));
+
+	// Conversions alone, over the same attribute text
+	float value = 0.0f;
+	start = chrono::steady_clock::now();
+	for (const char* text : values)
+	{
+		XMLUtil::ToFloat(text, &value);
+		checksum += value;
+	}
+	ReportRate("XMLUtil::ToFloat", attributes, bytes, SecondsSince(start));
+
+	start = chrono::steady_clock::now();
+	for (const char* text : values)
+	{
+		ScanFloat(text, &value);
+		checksum += value;
+	}
+	ReportRate("sscanf %f", attributes, bytes, SecondsSince(start));
+
+	char buffer[200];
+	size_t written = 0;
+	start = chrono::steady_clock::now();
+	for (size_t i = 0; i < attributes; i++)
+	{
+		XMLUtil::ToStr(position(rng), buffer, sizeof(buffer));
+		written += strlen(buffer);
+	}
+	ReportRate("XMLUtil::ToStr", attributes, written, SecondsSince(start));
+
+	written = 0;
+	start = chrono::steady_clock::now();
+	for (size_t i = 0; i < attributes; i++)
+		written += snprintf(buffer, sizeof(buffer), "%.8g", position(rng));
+	ReportRate("snprintf %.8g", attributes, written, SecondsSince(start));
+
+	cout << "Checksum " << checksum << endl;
+}
+
+// Writes N turret definition files (64 <Turret> elements each) to a temporary folder, then loads them all
+// with 1, 2, 4... threads up to the core count and reports the speedup over 1 thread.
+void RunXmlBatchBenchmark(size_t files)
+{
+	const filesystem::path folder = filesystem::temp_directory_path() / "xmlbatch";
+	filesystem::create_directories(folder);
+
+	mt19937 rng(1007);
+	uniform_real_distribution<float> position(0.0f, 1024.0f);
+	vector<string> paths(files);
+	for (size_t i = 0; i < files; i++)
+	{
+		XMLDocument doc;
+		for (int j = 0; j < 64; j++)
+		{
+			XMLElement* turret = doc.NewElement("Turret");
+			turret->SetAttribute("x", position(rng));
+			turret->SetAttribute("y", position(rng));
+			turret->SetAttribute("w", 100.0f);
+			turret->SetAttribute("h", 100.0f);
+			turret->SetAttribute("kills", j);
+			turret->SetAttribute("cooldown", 1.0f);
+			doc.InsertEndChild(turret);
+		}
+		paths[i] = (folder / ("turrets" + to_string(i) + ".xml")).string();
+		doc.SaveFile(paths[i].c_str());
+	}
+
+	// Sum each file's positions into its own slot, as a real loader would fill in its own definition
+	vector<float> sums(files);
+	auto read = [&](size_t index, const XMLDocument& doc)
+	{
+		float sum = 0.0f;
+		for (const XMLElement* turret = doc.FirstChildElement(); turret != nullptr; turret = turret->NextSiblingElement())
+			sum += turret->FloatAttribute("x") + turret->FloatAttribute("y");
+		sums[index] = sum;
+		return true;
+	};
+
+	const size_t cores = max(thread::hardware_concurrency(), 1u);
+	vector<size_t> threadCounts;
+	for (size_t threads = 1; threads < cores; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(cores);
+
+	// Start the pool's workers & warm their cached documents so the timings only measure loading
+	LoadXmlBatch(paths, read, cores);
+
+	double single = 0.0;
+	for (size_t threads : threadCounts)
+	{
+		const auto start = chrono::steady_clock::now();
+		const vector<XmlFileStatus> statuses = LoadXmlBatch(paths, read, threads);
+		const double elapsed = SecondsSince(start);
+		if (threads == 1)
+			single = elapsed;
+
+		const size_t failed = count_if(statuses.begin(), statuses.end(), [](const XmlFileStatus& status) { return !status.Ok(); });
+		cout << threads << " threads: " << elapsed * 1000.0 << " ms (" << files / elapsed << " files/s, "
+			<< single / elapsed << "x), " << failed << " failed" << endl;
+	}
+
+	StopXmlBatches();
+	filesystem::remove_all(folder);
+}
+
 int main(int argc, char* argv[])
 {
-	AppInit(SCREEN_WIDTH, SCREEN_HEIGHT);
+	Options options = ParseOptions(argc, argv);
+	if (options.xmlBench > 0)
+	{
+		RunXmlBenchmark(options.xmlBench);
+		return 0;
+	}
+	if (options.xmlBatch > 0)
+	{
+		RunXmlBatchBenchmark(options.xmlBatch);
+		return 0;
+	}
+
+	if (options.exportSave != nullptr || options.importSave != nullptr)
+	{
+		const bool exported = options.exportSave == nullptr || ExportSave(options.exportSave);
+		const bool imported = options.importSave == nullptr || ImportSave(options.importSave);
+		if (!exported) cout << "Couldn't export " << options.exportSave << ".snap" << endl;
+		if (!imported) cout << "Couldn't import " << options.importSave << ".xml" << endl;
+		return exported && imported ? 0 : 1;
+	}
+
+	AppInit(SCREEN_WIDTH, SCREEN_HEIGHT, options.headless);
+	if (options.tick > 0)
+		SetTickRate(options.tick);
+	if (options.trace > 0)
+		ProfileCapture(options.trace, "trace.json");
+	if (options.resident > 0)
+		Scene::SetResidentLimit(options.resident);
 	Scene::Init();
-	while (IsRunning())
+	if (options.scene >= 0 && (size_t)options.scene < Scene::COUNT && options.scene != Scene::TITLE)
+		Scene::Change((Scene::Type)options.scene);
+
+	if (options.headless)
+	{
+		RunHeadless(options);
+	}
+	else
 	{
-		Scene::Update(FrameTime());
-		RenderBegin();
-		Scene::Render();
-		RenderEnd();
+		while (IsRunning())
+		{
+			// Simulate in fixed steps so gameplay doesn't depend on frame rate, then render between the last two steps
+			while (Tick())
+				Scene::Update(TickTime());
+			RenderBegin();
+			Scene::Render();
+			RenderEnd();
+		}
 	}
 	Scene::Exit();
 	AppExit();
@@ -0,0 +1,137 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+
+// Refers to an object in a Pool. Stays valid while the object is alive no matter what else is added or removed.
+// Only odd generations are issued, so a default-constructed handle is always null.
+struct Handle
+{
+	Uint32 slot = 0;
+	Uint32 generation = 0;
+
+	bool operator==(const Handle& other) const { return slot == other.slot && generation == other.generation; }
+	bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Occupancy of a pool (or any other fixed-capacity container) for debug readouts
+struct PoolUsage
+{
+	size_t count = 0;
+	size_t capacity = 0;
+	size_t highWater = 0;	// Largest count since the pool was created
+};
+
+// Draws a pool's occupancy as a progress bar (must be called between ImGui::NewFrame & ImGui::Render)
+void PoolGui(const char* name, const PoolUsage& usage);
+
+// Fixed-capacity object pool. Objects are packed densely so they can be iterated like an array (in no particular order).
+// Slots map handles to dense indices and are recycled through a free list. Adding & removing are O(1) and never
+// allocate once Reserve has been called; Add fails (returns a null handle) when the pool is full.
+template<typename T>
+class Pool
+{
+public:
+	// Grows capacity to at least capacity (pools never shrink)
+	void Reserve(size_t capacity)
+	{
+		if (capacity <= mSlots.size()) return;
+
+		mItems.reserve(capacity);
+		mOwners.reserve(capacity);
+		mFree.reserve(capacity);
+
+		// Free list is a stack, so push new slots in reverse to hand out the lowest first
+		const Uint32 first = (Uint32)mSlots.size();
+		mSlots.resize(capacity);
+		for (Uint32 slot = (Uint32)capacity; slot > first; slot--)
+			mFree.push_back(slot - 1);
+	}
+
+	Handle Add(const T& item)
+	{
+		if (mFree.empty()) return {};
+
+		const Uint32 slot = mFree.back();
+		mFree.pop_back();
+
+		Slot& entry = mSlots[slot];
+		entry.index = (Uint32)mItems.size();
+		entry.generation++;
+
+		mItems.push_back(item);
+		mOwners.push_back(slot);
+		if (mItems.size() > mHighWater) mHighWater = mItems.size();
+		return { slot, entry.generation };
+	}
+
+	// Returns false if handle is null or stale
+	bool Remove(Handle handle)
+	{
+		if (!Valid(handle)) return false;
+		RemoveAt(mSlots[handle.slot].index);
+		return true;
+	}
+
+	// Removes the object at dense index i by moving the last object into its place
+	void RemoveAt(size_t i)
+	{
+		const Uint32 slot = mOwners[i];
+		mSlots[slot].generation++;	// Invalidates outstanding handles
+		mFree.push_back(slot);
+
+		const size_t last = mItems.size() - 1;
+		if (i != last)
+		{
+			mItems[i] = std::move(mItems[last]);
+			mOwners[i] = mOwners[last];
+			mSlots[mOwners[i]].index = (Uint32)i;
+		}
+		mItems.pop_back();
+		mOwners.pop_back();
+	}
+
+	void Clear()
+	{
+		while (!mItems.empty())
+			RemoveAt(mItems.size() - 1);
+	}
+
+	bool Valid(Handle handle) const
+	{
+		// Generations are odd while in use, which also rejects null handles
+		return (handle.generation & 1) != 0 && handle.slot < mSlots.size() && mSlots[handle.slot].generation == handle.generation;
+	}
+
+	// Returns nullptr if handle is null or stale
+	T* Get(Handle handle) { return Valid(handle) ? &mItems[mSlots[handle.slot].index] : nullptr; }
+	const T* Get(Handle handle) const { return Valid(handle) ? &mItems[mSlots[handle.slot].index] : nullptr; }
+
+	// Handle of the object at dense index i
+	Handle HandleAt(size_t i) const { return { mOwners[i], mSlots[mOwners[i]].generation }; }
+
+	T& operator[](size_t i) { return mItems[i]; }
+	const T& operator[](size_t i) const { return mItems[i]; }
+
+	typename std::vector<T>::iterator begin() { return mItems.begin(); }
+	typename std::vector<T>::iterator end() { return mItems.end(); }
+	typename std::vector<T>::const_iterator begin() const { return mItems.begin(); }
+	typename std::vector<T>::const_iterator end() const { return mItems.end(); }
+
+	size_t Count() const { return mItems.size(); }
+	size_t Capacity() const { return mSlots.size(); }
+	bool Full() const { return mFree.empty(); }
+	PoolUsage Usage() const { return { mItems.size(), mSlots.size(), mHighWater }; }
+
+private:
+	struct Slot
+	{
+		Uint32 index = 0;		// Dense index of the object while the slot is in use
+		Uint32 generation = 0;	// Incremented on every add & remove, so odd while in use
+	};
+
+	std::vector<T> mItems;			// Live objects, densely packed
+	std::vector<Uint32> mOwners;	// Slot of each live object
+	std::vector<Slot> mSlots;
+	std::vector<Uint32> mFree;		// Unused slots
+	size_t mHighWater = 0;
+};
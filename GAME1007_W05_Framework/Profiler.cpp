@@ -0,0 +1,367 @@
+#include "Profiler.h"
+#include "imgui/imgui.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+constexpr size_t PROFILE_FRAMES = 256;	// Frames of history
+constexpr size_t PROFILE_ZONES = 128;	// Zones recorded per frame (any more are dropped)
+constexpr int PROFILE_DEPTH = 32;		// Maximum zone nesting
+
+struct Zone
+{
+	const char* name = nullptr;
+	Uint64 start = 0;
+	Uint64 end = 0;
+	int depth = 0;
+};
+
+struct ProfileFrameData
+{
+	Uint64 start = 0;
+	Uint64 end = 0;
+	size_t count = 0;	// Zones recorded
+	size_t dropped = 0;	// Zones that didn't fit
+	array<Zone, PROFILE_ZONES> zones;
+};
+
+struct Profiler
+{
+	array<ProfileFrameData, PROFILE_FRAMES> frames;
+
+	// Frames completed so far. Only the main thread writes frames, so readers only need to see this
+	// advance after a frame's data is written to read it safely (until it's overwritten PROFILE_FRAMES later).
+	atomic<size_t> completed{ 0 };
+
+	array<size_t, PROFILE_DEPTH> stack{};	// Indices of open zones in the current frame
+	int depth = 0;
+
+	double frequency = (double)SDL_GetPerformanceFrequency();
+	bool visible = false;
+	bool paused = false;	// Stop refreshing the gui so a spike can be inspected
+	size_t shown = 0;		// Frame the gui shows while paused
+
+	// Trace capture. Frames are copied out of the ring as they complete so captures can be longer than the history
+	vector<ProfileFrameData> capture;
+	size_t captureFrames = 0;	// Frames wanted (0 when not capturing)
+	string capturePath;
+	thread writer;				// Writes the finished capture so file I/O doesn't disturb the frames being measured
+	atomic<bool> writing{ false };
+} gProfiler;
+
+// Writes frames as Chrome trace "complete" events (timestamps in microseconds from the first frame)
+void WriteTrace(vector<ProfileFrameData> frames, string path)
+{
+	const double frequency = gProfiler.frequency;
+	const Uint64 origin = frames.empty() ? 0 : frames.front().start;
+	auto micros = [&](Uint64 time) { return (time - origin) * 1000000.0 / frequency; };
+
+	ofstream file(path);
+	file.precision(3);
+	file << fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	auto event = [&](const string& name, Uint64 start, Uint64 end)
+	{
+		file << (first ? "" : ",\n") << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+			<< micros(start) << ",\"dur\":" << micros(end) - micros(start) << "}";
+		first = false;
+	};
+
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		const ProfileFrameData& frame = frames[i];
+		event("Frame " + to_string(i), frame.start, frame.end);
+		for (size_t j = 0; j < frame.count; j++)
+		{
+			// Zone names are literals, but escape anything that would break the JSON
+			string name;
+			for (const char* c = frame.zones[j].name; *c != '\0'; c++)
+			{
+				if (*c == '"' || *c == '\\') name += '\\';
+				name += *c;
+			}
+			event(name, frame.zones[j].start, frame.zones[j].end);
+		}
+	}
+	file << "\n]}\n";
+	SDL_Log("Wrote %zu frames to %s", frames.size(), path.c_str());
+	gProfiler.writing = false;
+}
+
+ProfileFrameData& CurrentFrame()
+{
+	return gProfiler.frames[gProfiler.completed.load(memory_order_relaxed) % PROFILE_FRAMES];
+}
+
+void ProfileBegin(const char* name)
+{
+	ProfileFrameData& frame = CurrentFrame();
+	if (frame.start == 0) frame.start = SDL_GetPerformanceCounter();
+
+	if (gProfiler.depth >= PROFILE_DEPTH)
+	{
+		frame.dropped++;
+		gProfiler.depth++;
+		return;
+	}
+
+	if (frame.count >= PROFILE_ZONES)
+	{
+		frame.dropped++;
+		gProfiler.stack[gProfiler.depth++] = PROFILE_ZONES;	// Nothing to close
+		return;
+	}
+
+	Zone& zone = frame.zones[frame.count];
+	zone.name = name;
+	zone.depth = gProfiler.depth;
+	zone.start = SDL_GetPerformanceCounter();
+	zone.end = 0;
+	gProfiler.stack[gProfiler.depth++] = frame.count++;
+}
+
+void ProfileEnd()
+{
+	if (gProfiler.depth <= 0) return;
+	gProfiler.depth--;
+
+	ProfileFrameData& frame = CurrentFrame();
+	if (gProfiler.depth >= PROFILE_DEPTH) return;
+
+	size_t index = gProfiler.stack[gProfiler.depth];
+	if (index < frame.count)
+		frame.zones[index].end = SDL_GetPerformanceCounter();
+}
+
+void ProfileFrame()
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	ProfileFrameData& frame = CurrentFrame();
+	if (frame.start == 0) frame.start = now;
+	frame.end = now;
+
+	// Close anything left open (ie a scene change mid-zone) so the frame is self-contained
+	for (size_t i = 0; i < frame.count; i++)
+		if (frame.zones[i].end == 0) frame.zones[i].end = now;
+	gProfiler.depth = 0;
+
+	if (gProfiler.captureFrames > 0)
+	{
+		// Only copy the zones actually recorded
+		gProfiler.capture.emplace_back();
+		ProfileFrameData& copy = gProfiler.capture.back();
+		copy.start = frame.start;
+		copy.end = frame.end;
+		copy.count = frame.count;
+		copy.dropped = frame.dropped;
+		std::copy(frame.zones.begin(), frame.zones.begin() + frame.count, copy.zones.begin());
+
+		if (gProfiler.capture.size() >= gProfiler.captureFrames)
+		{
+			if (gProfiler.writer.joinable()) gProfiler.writer.join();
+			gProfiler.writing = true;
+			gProfiler.writer = thread(WriteTrace, move(gProfiler.capture), gProfiler.capturePath);
+			gProfiler.capture = {};
+			gProfiler.captureFrames = 0;
+		}
+	}
+
+	// Publish, then reset the slot the next frame writes to
+	size_t next = gProfiler.completed.load(memory_order_relaxed) + 1;
+	gProfiler.completed.store(next, memory_order_release);
+
+	ProfileFrameData& nextFrame = gProfiler.frames[next % PROFILE_FRAMES];
+	nextFrame.start = now;
+	nextFrame.end = 0;
+	nextFrame.count = 0;
+	nextFrame.dropped = 0;
+}
+
+void ProfileCapture(size_t frames, const char* path)
+{
+	if (gProfiler.captureFrames > 0 || gProfiler.writing) return;
+
+	// Reserve up-front so capturing doesn't allocate mid-frame
+	gProfiler.capture.clear();
+	gProfiler.capture.reserve(frames);
+	gProfiler.captureFrames = frames;
+	gProfiler.capturePath = path;
+}
+
+void ProfilerShutdown()
+{
+	if (gProfiler.writer.joinable())
+		gProfiler.writer.join();
+}
+
+void ProfilerToggle()
+{
+	gProfiler.visible = !gProfiler.visible;
+}
+
+// Duration of a zone or frame in milliseconds
+double Milliseconds(Uint64 start, Uint64 end)
+{
+	return (end - start) * 1000.0 / gProfiler.frequency;
+}
+
+// Value below which percent of (sorted) samples fall
+double Percentile(const vector<double>& sorted, double percent)
+{
+	if (sorted.empty()) return 0.0;
+	size_t index = (size_t)ceil(sorted.size() * percent) - 1;
+	return sorted[min(index, sorted.size() - 1)];
+}
+
+void DrawFlameGraph(const ProfileFrameData& frame)
+{
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	int rows = 1;
+	for (size_t i = 0; i < frame.count; i++)
+		rows = max(rows, frame.zones[i].depth + 1);
+
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = max(ImGui::GetContentRegionAvail().x, 100.0f);
+	ImGui::InvisibleButton("FlameGraph", { width, rowHeight * rows });
+
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	const double duration = (double)max<Uint64>(frame.end - frame.start, 1);
+	for (size_t i = 0; i < frame.count; i++)
+	{
+		const Zone& zone = frame.zones[i];
+		float x0 = origin.x + (float)((zone.start - frame.start) / duration) * width;
+		float x1 = origin.x + (float)((zone.end - frame.start) / duration) * width;
+		float y0 = origin.y + zone.depth * rowHeight;
+		ImVec2 min{ x0, y0 };
+		ImVec2 max{ std::max(x1, x0 + 1.0f), y0 + rowHeight - 1.0f };
+
+		// Colour by name so the same zone is recognizable between frames
+		ImU32 hash = ImGui::GetID(zone.name);
+		ImU32 color = IM_COL32(96 + (hash & 0x7F), 96 + ((hash >> 8) & 0x7F), 96 + ((hash >> 16) & 0x7F), 255);
+		drawList->AddRectFilled(min, max, color);
+
+		drawList->PushClipRect(min, max, true);
+		drawList->AddText({ x0 + 2.0f, y0 }, IM_COL32_BLACK, zone.name);
+		drawList->PopClipRect();
+
+		if (ImGui::IsMouseHoveringRect(min, max))
+			ImGui::SetTooltip("%s: %.3f ms", zone.name, Milliseconds(zone.start, zone.end));
+	}
+}
+
+void ProfilerGui()
+{
+	if (!gProfiler.visible) return;
+
+	size_t completed = gProfiler.completed.load(memory_order_acquire);
+	if (completed == 0) return;
+
+	if (!gProfiler.paused) gProfiler.shown = completed - 1;
+	if (completed - gProfiler.shown > PROFILE_FRAMES) gProfiler.shown = completed - 1;
+
+	ImGui::SetNextWindowSize({ 600.0f, 500.0f }, ImGuiCond_FirstUseEver);
+	if (!ImGui::Begin("Profiler", &gProfiler.visible))
+	{
+		ImGui::End();
+		return;
+	}
+
+	const ProfileFrameData& shown = gProfiler.frames[gProfiler.shown % PROFILE_FRAMES];
+	ImGui::Checkbox("Paused", &gProfiler.paused);
+	ImGui::SameLine();
+	ImGui::Text("Frame %zu: %.3f ms", gProfiler.shown, Milliseconds(shown.start, shown.end));
+	if (shown.dropped > 0)
+	{
+		ImGui::SameLine();
+		ImGui::TextColored({ 1.0f, 0.4f, 0.4f, 1.0f }, "(%zu zones dropped)", shown.dropped);
+	}
+	DrawFlameGraph(shown);
+
+	if (gProfiler.captureFrames > 0)
+		ImGui::Text("Capturing trace: %zu/%zu frames", gProfiler.capture.size(), gProfiler.captureFrames);
+	else if (gProfiler.writing)
+		ImGui::Text("Writing %s...", gProfiler.capturePath.c_str());
+	else if (ImGui::Button("Capture trace (F2)"))
+		ProfileCapture(300, "trace.json");
+
+	// Gather per-frame totals of each zone across the history
+	const size_t count = min(completed, PROFILE_FRAMES);
+	vector<float> frameTimes;
+	vector<double> sortedFrameTimes;
+	unordered_map<const char*, vector<double>> zoneTimes;
+	vector<const char*> zoneOrder;
+	for (size_t i = completed - count; i < completed; i++)
+	{
+		const ProfileFrameData& frame = gProfiler.frames[i % PROFILE_FRAMES];
+		double frameTime = Milliseconds(frame.start, frame.end);
+		frameTimes.push_back((float)frameTime);
+		sortedFrameTimes.push_back(frameTime);
+
+		unordered_map<const char*, double> totals;
+		for (size_t j = 0; j < frame.count; j++)
+			totals[frame.zones[j].name] += Milliseconds(frame.zones[j].start, frame.zones[j].end);
+
+		for (auto& total : totals)
+		{
+			vector<double>& times = zoneTimes[total.first];
+			if (times.empty()) zoneOrder.push_back(total.first);
+			times.push_back(total.second);
+		}
+	}
+
+	sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+	ImGui::Separator();
+	ImGui::Text("Frame time over %zu frames: min %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms", count,
+		sortedFrameTimes.front(), Percentile(sortedFrameTimes, 0.5), Percentile(sortedFrameTimes, 0.99), sortedFrameTimes.back());
+	ImGui::PlotLines("##FrameTimes", frameTimes.data(), (int)frameTimes.size(), 0, "Frame time (ms)",
+		0.0f, (float)sortedFrameTimes.back(), { ImGui::GetContentRegionAvail().x, 60.0f });
+
+	// Histogram of frame times in 32 buckets from 0 to the slowest frame
+	array<float, 32> buckets{};
+	const double bucketSize = max(sortedFrameTimes.back(), 0.001) / buckets.size();
+	for (double frameTime : sortedFrameTimes)
+		buckets[min((size_t)(frameTime / bucketSize), buckets.size() - 1)] += 1.0f;
+	char label[64];
+	snprintf(label, sizeof(label), "0 to %.2f ms", sortedFrameTimes.back());
+	ImGui::PlotHistogram("##FrameHistogram", buckets.data(), (int)buckets.size(), 0, label,
+		0.0f, FLT_MAX, { ImGui::GetContentRegionAvail().x, 60.0f });
+
+	if (ImGui::BeginTable("Zones", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+	{
+		ImGui::TableSetupColumn("Zone");
+		ImGui::TableSetupColumn("Min (ms)");
+		ImGui::TableSetupColumn("Avg (ms)");
+		ImGui::TableSetupColumn("p99 (ms)");
+		ImGui::TableSetupColumn("Max (ms)");
+		ImGui::TableHeadersRow();
+
+		for (const char* name : zoneOrder)
+		{
+			vector<double>& times = zoneTimes[name];
+			sort(times.begin(), times.end());
+			double sum = 0.0;
+			for (double time : times)
+				sum += time;
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(name);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", times.front());
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", sum / times.size());
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", Percentile(times, 0.99));
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", times.back());
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
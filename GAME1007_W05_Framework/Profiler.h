@@ -0,0 +1,27 @@
+#pragma once
+#include <SDL.h>
+
+// Records nested, named time zones per frame into a ring buffer of the most recent frames.
+// Usage: PROFILE_SCOPE("Name"); at the top of any block. Zones are closed when the block exits.
+// Press F1 to show the profiler window (flame graph of the last frame, per-zone stats & frame time histogram).
+// Press F2 (or pass --trace=N) to capture frames to a Chrome trace file (open in about:tracing or ui.perfetto.dev).
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+void ProfileBegin(const char* name);	// Opens a zone (name must be a string literal or otherwise outlive the profiler)
+void ProfileEnd();						// Closes the most recently opened zone
+void ProfileFrame();					// Ends the current frame and starts the next one
+
+void ProfileCapture(size_t frames, const char* path);	// Records the next frames then writes them to path on a worker thread
+void ProfilerShutdown();	// Waits for any trace still being written
+
+void ProfilerToggle();	// Show/hide the profiler window
+void ProfilerGui();		// Draws the profiler window if visible (must be called between ImGui::NewFrame & ImGui::Render)
+
+struct ProfileScope
+{
+	ProfileScope(const char* name) { ProfileBegin(name); }
+	~ProfileScope() { ProfileEnd(); }
+};
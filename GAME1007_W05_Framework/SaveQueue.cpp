@@ -0,0 +1,122 @@
+#include "SaveQueue.h"
+#include <SDL.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+struct SaveQueue
+{
+	struct Job
+	{
+		string path;
+		SaveWriter writer;
+	};
+
+	thread worker;				// Started by the first save
+	mutex lock;					// Guards everything below
+	condition_variable wake;	// Signals the worker when there's a job or it should stop
+	condition_variable written;	// Signals waiters whenever a job finishes
+	deque<Job> pending;
+	string writing;				// Path of the job in progress (empty if none)
+	bool stopping = false;
+} gSaves;
+
+static bool Pending(const string& path)
+{
+	return gSaves.writing == path || any_of(gSaves.pending.begin(), gSaves.pending.end(),
+		[&](const SaveQueue::Job& job) { return job.path == path; });
+}
+
+// Writes beside the destination then renames over it, so a crash mid-write never leaves a truncated save
+static void Write(const SaveQueue::Job& job)
+{
+	const string temp = job.path + ".tmp";
+	if (!job.writer(temp.c_str()))
+	{
+		SDL_Log("Failed to save %s", job.path.c_str());
+		remove(temp.c_str());
+		return;
+	}
+
+	error_code error;
+	filesystem::rename(temp, job.path, error);
+	if (error)
+	{
+		SDL_Log("Failed to replace %s: %s", job.path.c_str(), error.message().c_str());
+		remove(temp.c_str());
+	}
+}
+
+static void SaveWorker()
+{
+	unique_lock<mutex> lock(gSaves.lock);
+	while (true)
+	{
+		// Stopping only ends the thread once everything queued has been written
+		gSaves.wake.wait(lock, [] { return gSaves.stopping || !gSaves.pending.empty(); });
+		if (gSaves.pending.empty()) return;
+
+		SaveQueue::Job job = move(gSaves.pending.front());
+		gSaves.pending.pop_front();
+		gSaves.writing = job.path;
+
+		lock.unlock();
+		Write(job);
+		lock.lock();
+
+		gSaves.writing.clear();
+		gSaves.written.notify_all();
+	}
+}
+
+void QueueSave(const char* path, SaveWriter writer)
+{
+	{
+		lock_guard<mutex> lock(gSaves.lock);
+		if (!gSaves.worker.joinable())
+		{
+			gSaves.stopping = false;
+			gSaves.worker = thread(SaveWorker);
+		}
+
+		// Coalesce with a save of the same file that hasn't started
+		auto queued = find_if(gSaves.pending.begin(), gSaves.pending.end(),
+			[&](const SaveQueue::Job& job) { return job.path == path; });
+		if (queued != gSaves.pending.end())
+			queued->writer = move(writer);
+		else
+			gSaves.pending.push_back({ path, move(writer) });
+	}
+	gSaves.wake.notify_one();
+}
+
+void WaitForSave(const char* path)
+{
+	const string file = path;
+	unique_lock<mutex> lock(gSaves.lock);
+	gSaves.written.wait(lock, [&] { return !Pending(file); });
+}
+
+void FlushSaves()
+{
+	unique_lock<mutex> lock(gSaves.lock);
+	gSaves.written.wait(lock, [] { return gSaves.pending.empty() && gSaves.writing.empty(); });
+}
+
+void StopSaves()
+{
+	{
+		lock_guard<mutex> lock(gSaves.lock);
+		if (!gSaves.worker.joinable()) return;
+		gSaves.stopping = true;
+	}
+	gSaves.wake.notify_one();
+	gSaves.worker.join();
+}
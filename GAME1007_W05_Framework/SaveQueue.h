@@ -0,0 +1,14 @@
+#pragma once
+#include <functional>
+
+// Writes save files on a background thread so scenes never wait on disk I/O.
+// Capture the state to save by value on the main thread; the writer then runs on the save thread.
+// Writes are atomic (the writer writes path.tmp, which then replaces path), and a queued save that
+// hasn't started yet is replaced by a newer save of the same path rather than written twice.
+
+using SaveWriter = std::function<bool(const char* path)>;	// Writes the file at path, returning false on failure
+
+void QueueSave(const char* path, SaveWriter writer);
+void WaitForSave(const char* path);	// Blocks until any queued save of path has been written (call before reading it)
+void FlushSaves();					// Blocks until every queued save has been written
+void StopSaves();					// Flushes, then stops the save thread (called by AppExit)
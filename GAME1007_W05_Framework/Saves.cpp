@@ -0,0 +1,241 @@
+#include "Saves.h"
+#include "CachedDocument.h"
+#include "Fields.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using namespace std;
+using namespace tinyxml2;
+
+constexpr Uint32 GAME_SAVE = FourCC('G', 'A', 'M', 'E');
+constexpr Uint32 ASTEROIDS_SAVE = FourCC('A', 'S', 'T', 'G');
+constexpr Uint32 LAB2_SAVE = FourCC('T', 'U', 'R', 'R');
+constexpr Uint16 SAVE_VERSION = 1;
+
+// Each save's fields, shared by the XML & snapshot formats. Snapshots store them in this order.
+constexpr Field GAME_FIELDS[] = {
+	FIELD(GameSave, "Ship", "x", ship.x),
+	FIELD(GameSave, "Ship", "y", ship.y),
+	FIELD(GameSave, "Ship", "w", ship.w),
+	FIELD(GameSave, "Ship", "h", ship.h),
+	FIELD(GameSave, "Ship", "speed", speed),
+};
+static_assert(ValidFields(GAME_FIELDS), "GameSave fields must be grouped by element with unique names");
+
+constexpr Field ASTEROIDS_FIELDS[] = {
+	FIELD(AsteroidsSave, "Ship", "x", ship.x),
+	FIELD(AsteroidsSave, "Ship", "y", ship.y),
+	FIELD(AsteroidsSave, "Ship", "w", ship.w),
+	FIELD(AsteroidsSave, "Ship", "h", ship.h),
+	FIELD(AsteroidsSave, "Ship", "speed", speed),
+	FIELD(AsteroidsSave, "Ship", "angspeed", angularSpeed),
+	FIELD(AsteroidsSave, "Ship", "bulletcooldownduration", bulletCooldown),
+	FIELD(AsteroidsSave, "Ship", "xPosition", position.x),
+	FIELD(AsteroidsSave, "Ship", "yPosition", position.y),
+	FIELD(AsteroidsSave, "Ast", "timerElasped", timerElapsed),
+	FIELD(AsteroidsSave, "Ast", "timerDuration", timerDuration),
+};
+static_assert(ValidFields(ASTEROIDS_FIELDS), "AsteroidsSave fields must be grouped by element with unique names");
+
+// Attributes of each <Turret>
+constexpr Field TURRET_FIELDS[] = {
+	FIELD(TurretSave, nullptr, "x", rec.x),
+	FIELD(TurretSave, nullptr, "y", rec.y),
+	FIELD(TurretSave, nullptr, "w", rec.w),
+	FIELD(TurretSave, nullptr, "h", rec.h),
+	FIELD(TurretSave, nullptr, "cooldown", cooldown),
+	FIELD(TurretSave, nullptr, "kills", kills),
+};
+static_assert(ValidFields(TURRET_FIELDS), "TurretSave fields must have unique names");
+
+// Reads fields from the root element's children, leaving save unchanged if any element is missing
+template<typename Save, size_t N>
+static bool LoadXml(const char* path, const Field (&fields)[N], Save& save)
+{
+	CachedDocument doc;
+	if (doc->LoadFile(path) != XML_SUCCESS) return false;
+
+	const XMLElement* root = doc->FirstChildElement();
+	Save result = save;
+	if (root == nullptr || !LoadFields(*root, fields, result)) return false;
+	save = result;
+	return true;
+}
+
+bool LoadXml(const char* path, GameSave& save)
+{
+	return LoadXml(path, GAME_FIELDS, save);
+}
+
+bool LoadXml(const char* path, AsteroidsSave& save)
+{
+	return LoadXml(path, ASTEROIDS_FIELDS, save);
+}
+
+bool LoadXml(const char* path, Lab2Save& save)
+{
+	// Streamed rather than loaded into a document since levels can hold a great many turrets
+	XMLStreamReader reader;
+	if (reader.Open(path) != XML_SUCCESS) return false;
+
+	// One <Turret> element per turret at the top level
+	Lab2Save result;
+	XMLStreamReader::Event event;
+	while ((event = reader.Next()) != XMLStreamReader::END_DOCUMENT)
+	{
+		if (event == XMLStreamReader::STREAM_ERROR) return false;
+		if (event != XMLStreamReader::START_ELEMENT || reader.Depth() != 1) continue;
+
+		TurretSave turret;
+		LoadFields(reader, TURRET_FIELDS, turret);
+		result.turrets.push_back(turret);
+	}
+	save = move(result);
+	return true;
+}
+
+bool SaveXml(const char* path, const GameSave& save)
+{
+	CachedDocument doc;
+	XMLElement* root = doc->NewElement("Game");
+	doc->InsertEndChild(root);
+	SaveFields(*root, GAME_FIELDS, save);
+	return doc->SaveFile(path) == XML_SUCCESS;
+}
+
+bool SaveXml(const char* path, const AsteroidsSave& save)
+{
+	CachedDocument doc;
+	XMLElement* root = doc->NewElement("AstGame");
+	doc->InsertEndChild(root);
+	SaveFields(*root, ASTEROIDS_FIELDS, save);
+
+	// Pool capacities are configuration rather than game state, so carry them over unchanged
+	CachedDocument previous;
+	previous->LoadFile(path);
+	XMLElement* previousRoot = previous->FirstChildElement();
+	XMLElement* pools = previousRoot != nullptr ? previousRoot->FirstChildElement("Pools") : nullptr;
+	if (pools != nullptr)
+		root->InsertEndChild(pools->DeepClone(doc.Get()));
+
+	return doc->SaveFile(path) == XML_SUCCESS;
+}
+
+bool SaveXml(const char* path, const Lab2Save& save)
+{
+	CachedDocument doc;
+	for (const TurretSave& turret : save.turrets)
+	{
+		XMLElement* element = doc->NewElement("Turret");
+		SaveFields(*element, TURRET_FIELDS, turret);
+		doc->InsertEndChild(element);
+	}
+	return doc->SaveFile(path) == XML_SUCCESS;
+}
+
+template<typename Save, size_t N>
+static bool LoadSnapshot(const char* path, Uint32 kind, const Field (&fields)[N], Save& save)
+{
+	SnapshotReader reader;
+	if (!reader.Load(path, kind, SAVE_VERSION)) return false;
+
+	Save result;
+	if (!ReadFields(reader, fields, result)) return false;
+	save = result;
+	return true;
+}
+
+template<typename Save, size_t N>
+static bool SaveSnapshot(const char* path, Uint32 kind, const Field (&fields)[N], const Save& save)
+{
+	SnapshotWriter writer;
+	writer.Begin(kind, SAVE_VERSION, FieldsSize(fields));
+	WriteFields(writer, fields, save);
+	writer.End();
+	return writer.Save(path);
+}
+
+bool LoadSnapshot(const char* path, GameSave& save)
+{
+	return LoadSnapshot(path, GAME_SAVE, GAME_FIELDS, save);
+}
+
+bool LoadSnapshot(const char* path, AsteroidsSave& save)
+{
+	return LoadSnapshot(path, ASTEROIDS_SAVE, ASTEROIDS_FIELDS, save);
+}
+
+bool LoadSnapshot(const char* path, Lab2Save& save)
+{
+	SnapshotReader reader;
+	if (!reader.Load(path, LAB2_SAVE, SAVE_VERSION)) return false;
+
+	Uint32 count = 0;
+	reader.Read(count);
+
+	// Cap the allocation in case of a bogus count (reading past the end of the payload fails anyway)
+	Lab2Save result;
+	result.turrets.resize(reader.Ok() ? min<size_t>(count, 1u << 20) : 0);
+	for (TurretSave& turret : result.turrets)
+	{
+		if (!ReadFields(reader, TURRET_FIELDS, turret)) return false;
+	}
+	if (!reader.Ok() || result.turrets.size() != count) return false;
+	save = move(result);
+	return true;
+}
+
+bool SaveSnapshot(const char* path, const GameSave& save)
+{
+	return SaveSnapshot(path, GAME_SAVE, GAME_FIELDS, save);
+}
+
+bool SaveSnapshot(const char* path, const AsteroidsSave& save)
+{
+	return SaveSnapshot(path, ASTEROIDS_SAVE, ASTEROIDS_FIELDS, save);
+}
+
+bool SaveSnapshot(const char* path, const Lab2Save& save)
+{
+	SnapshotWriter writer;
+	writer.Begin(LAB2_SAVE, SAVE_VERSION, 4 + save.turrets.size() * FieldsSize(TURRET_FIELDS));
+	writer.Write((Uint32)save.turrets.size());
+	for (const TurretSave& turret : save.turrets)
+		WriteFields(writer, TURRET_FIELDS, turret);
+	writer.End();
+	return writer.Save(path);
+}
+
+template<typename Save>
+bool Convert(const string& from, const string& to, bool toXml)
+{
+	Save save;
+	if (toXml)
+		return LoadSnapshot(from.c_str(), save) && SaveXml(to.c_str(), save);
+	return LoadXml(from.c_str(), save) && SaveSnapshot(to.c_str(), save);
+}
+
+bool Convert(const char* name, bool toXml)
+{
+	const string snapshot = string(name) + ".snap";
+	const string xml = string(name) + ".xml";
+	const string& from = toXml ? snapshot : xml;
+	const string& to = toXml ? xml : snapshot;
+
+	if (strcmp(name, "Game") == 0) return Convert<GameSave>(from, to, toXml);
+	if (strcmp(name, "AstGame") == 0) return Convert<AsteroidsSave>(from, to, toXml);
+	if (strcmp(name, "Turrets") == 0) return Convert<Lab2Save>(from, to, toXml);
+	return false;
+}
+
+bool ExportSave(const char* name)
+{
+	return Convert(name, true);
+}
+
+bool ImportSave(const char* name)
+{
+	return Convert(name, false);
+}
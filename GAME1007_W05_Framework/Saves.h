@@ -0,0 +1,78 @@
+#pragma once
+#include "Math.h"
+#include "SaveQueue.h"
+#include <vector>
+
+// Persistent scene state. Each save is stored as a binary snapshot (NAME.snap, see Snapshot.h) which scenes read & write,
+// and can be converted to & from XML (NAME.xml) for editing by hand with --export=NAME / --import=NAME.
+// Loading falls back to the XML if there's no valid snapshot.
+
+// GameScene (Game)
+struct GameSave
+{
+	Rect ship{};
+	float speed = 0.0f;
+};
+
+// AsteroidsScene (AstGame). Fields mirror the XML attributes.
+struct AsteroidsSave
+{
+	Rect ship{};					// x, y, w, h
+	float speed = 0.0f;
+	float angularSpeed = 0.0f;		// angspeed
+	float bulletCooldown = 0.0f;	// bulletcooldownduration
+	Point position{};				// xPosition, yPosition
+	float timerElapsed = 0.0f;		// timerElasped
+	float timerDuration = 0.0f;
+};
+
+// Lab2Scene (Turrets)
+struct TurretSave
+{
+	Rect rec{};
+	float cooldown = 1.0f;
+	int kills = 0;
+};
+
+struct Lab2Save
+{
+	std::vector<TurretSave> turrets;
+};
+
+bool LoadXml(const char* path, GameSave& save);
+bool LoadXml(const char* path, AsteroidsSave& save);
+bool LoadXml(const char* path, Lab2Save& save);
+bool SaveXml(const char* path, const GameSave& save);
+bool SaveXml(const char* path, const AsteroidsSave& save);	// Keeps the file's <Pools> configuration
+bool SaveXml(const char* path, const Lab2Save& save);
+
+bool LoadSnapshot(const char* path, GameSave& save);
+bool LoadSnapshot(const char* path, AsteroidsSave& save);
+bool LoadSnapshot(const char* path, Lab2Save& save);
+bool SaveSnapshot(const char* path, const GameSave& save);
+bool SaveSnapshot(const char* path, const AsteroidsSave& save);
+bool SaveSnapshot(const char* path, const Lab2Save& save);
+
+// Loads NAME.snap, or NAME.xml if the snapshot is missing or corrupt. Returns false if neither could be loaded.
+// Waits for a queued save of the snapshot so the load never sees a stale file.
+template<typename Save>
+bool LoadSave(const char* name, Save& save)
+{
+	char path[256];
+	SDL_snprintf(path, sizeof(path), "%s.snap", name);
+	WaitForSave(path);
+	if (LoadSnapshot(path, save)) return true;
+	SDL_snprintf(path, sizeof(path), "%s.xml", name);
+	return LoadXml(path, save);
+}
+
+// Writes a copy of save to a snapshot on the save thread (see SaveQueue.h)
+template<typename Save>
+void QueueSnapshot(const char* path, const Save& save)
+{
+	QueueSave(path, [save](const char* file) { return SaveSnapshot(file, save); });
+}
+
+// Converts NAME.snap to NAME.xml (export) or NAME.xml to NAME.snap (import). NAME is Game, AstGame or Turrets.
+bool ExportSave(const char* name);
+bool ImportSave(const char* name);
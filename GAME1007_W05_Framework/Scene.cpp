@@ -1,5 +1,7 @@
 #include "Scene.h"
 #include "tinyxml2.h"
+#include "CachedDocument.h"
+#include "Saves.h"
 #include <iostream>
 #include <cassert>
 #include <algorithm>
@@ -9,56 +11,269 @@ using namespace tinyxml2;
 
 Scene::Type Scene::sCurrent;
 std::array<Scene*, Scene::COUNT> Scene::sScenes;
+std::array<size_t, Scene::COUNT> Scene::sLastEntered;
+size_t Scene::sEntries = 0;
+size_t Scene::sResidentLimit = Scene::COUNT;
+Scene::Type Scene::sNext = Scene::COUNT;
+bool Scene::sPushing = false;
+float Scene::sFadeDuration = 0.0f;
+float Scene::sFade = 0.0f;
+Texture* Scene::sFadeTarget = nullptr;
+std::vector<Scene::Type> Scene::sPaused;
+Texture* Scene::sUnderlayTarget = nullptr;
 
 void Scene::Init()
 {
-	sScenes[TITLE] = new TitleScene;
-	sScenes[GAME] = new GameScene;
-	sScenes[LAB_1A] = new Lab1AScene;
-	sScenes[LAB_1B] = new Lab1BScene;
-	sScenes[LAB_2] = new Lab2Scene;
-	sScenes[LOSE] = new LoseScene;
-	sScenes[PAUSE] = new PauseScene;
-	sScenes[ASTEROIDS] = new AsteroidsScene;
+	// Gameplay sprites share atlas pages so they can be drawn without texture switches
+	LoadAtlas({
+		"../Assets/img/enterprise.png",
+		"../Assets/img/d7.png",
+		"../Assets/img/bolt.png",
+		"../Assets/img/asteriod.png",
+		"../Assets/img/explosion.png",
+		"../Assets/img/button.png"
+	});
+
+	// Only the title scene is loaded up-front, the rest are created when first entered
 	sCurrent = TITLE;
+	sScenes[sCurrent] = Create(sCurrent);
+	sLastEntered[sCurrent] = ++sEntries;
 	sScenes[sCurrent]->OnEnter();
 }
 
 void Scene::Exit()
 {
 	sScenes[sCurrent]->OnExit();
+	for (auto paused = sPaused.rbegin(); paused != sPaused.rend(); paused++)
+		sScenes[*paused]->OnExit();
+	sPaused.clear();
+
 	for (size_t i = 0; i < sScenes.size(); i++)
+	{
 		delete sScenes[i];
+		sScenes[i] = nullptr;
+	}
+	DestroyRenderTarget(sFadeTarget);
+	DestroyRenderTarget(sUnderlayTarget);
+	sFadeTarget = sUnderlayTarget = nullptr;
+	UnloadAtlas();
 }
 
 void Scene::Update(float dt)
 {
+	PROFILE_SCOPE("Scene::Update");
+	if (sNext != COUNT && sScenes[sNext]->IsReady())
+		FinishTransition();
 	sScenes[sCurrent]->OnUpdate(dt);
 }
 
 void Scene::Render()
 {
+	PROFILE_SCOPE("Scene::Render");
 	sScenes[sCurrent]->OnRender();
+
+	if (sFade > 0.0f)
+	{
+		const Uint8 alpha = (Uint8)(Clamp(sFade / sFadeDuration, 0.0f, 1.0f) * 255.0f);
+		DrawTexture(sFadeTarget, { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT }, SCREEN, 0.0f, { 255, 255, 255, alpha });
+		sFade -= FrameTime();
+	}
+}
+
+void Scene::Transition(Type type, float fade)
+{
+	if (type == sCurrent || (type == sNext && !sPushing)) return;
+
+	// Creating the scene starts its asynchronous loads
+	if (sScenes[type] == nullptr)
+		sScenes[type] = Create(type);
+	sScenes[type]->OnPreload();
+	sNext = type;
+	sPushing = false;
+	sFadeDuration = fade;
+}
+
+void Scene::FinishTransition()
+{
+	if (sPushing)
+	{
+		FinishPush();
+		return;
+	}
+
+	// Keep the outgoing scene's last frame to fade out over the incoming scene (nothing is presented when headless)
+	sFade = 0.0f;
+	if (sFadeDuration > 0.0f && !IsHeadless())
+	{
+		if (sFadeTarget == nullptr)
+			sFadeTarget = CreateRenderTarget(SCREEN_WIDTH, SCREEN_HEIGHT);
+		if (sFadeTarget != nullptr)
+		{
+			SetRenderTarget(sFadeTarget);
+			sScenes[sCurrent]->OnRender();
+			SetRenderTarget(nullptr);
+			sFade = sFadeDuration;
+		}
+	}
+	Change(sNext);
 }
 
 void Scene::Change(Type type)
 {
 	assert(sCurrent != type);
+	sNext = COUNT;
+	sPushing = false;
 	sScenes[sCurrent]->OnExit();
+
+	// Paused scenes are left behind too
+	while (!sPaused.empty())
+	{
+		sScenes[sPaused.back()]->OnExit();
+		sPaused.pop_back();
+	}
+
 	sCurrent = type;
+	if (sScenes[sCurrent] == nullptr)
+		sScenes[sCurrent] = Create(sCurrent);
+	sLastEntered[sCurrent] = ++sEntries;
 	sScenes[sCurrent]->OnEnter();
+	Evict();
+}
+
+void Scene::Push(Type type)
+{
+	assert(sCurrent != type);
+	assert(find(sPaused.begin(), sPaused.end(), type) == sPaused.end());
+	if (type == sNext && sPushing) return;
+
+	// Entered by FinishPush once ready, so pushing never stalls a frame on loading either
+	if (sScenes[type] == nullptr)
+		sScenes[type] = Create(type);
+	sScenes[type]->OnPreload();
+	sNext = type;
+	sPushing = true;
+}
+
+void Scene::FinishPush()
+{
+	const Type type = sNext;
+	sNext = COUNT;
+	sPushing = false;
+
+	// Keep the paused scene's last frame so overlays can draw it without re-rendering it every frame
+	if (!IsHeadless())
+	{
+		if (sUnderlayTarget == nullptr)
+			sUnderlayTarget = CreateRenderTarget(SCREEN_WIDTH, SCREEN_HEIGHT);
+		if (sUnderlayTarget != nullptr)
+		{
+			SetRenderTarget(sUnderlayTarget);
+			sScenes[sCurrent]->OnRender();
+			SetRenderTarget(nullptr);
+		}
+	}
+
+	sScenes[sCurrent]->OnPause();
+	sPaused.push_back(sCurrent);
+	sCurrent = type;
+	sLastEntered[sCurrent] = ++sEntries;
+	sScenes[sCurrent]->OnEnter();
+	Evict();
+}
+
+void Scene::Pop()
+{
+	assert(!sPaused.empty());
+	sNext = COUNT;
+	sPushing = false;
+	sScenes[sCurrent]->OnExit();
+	sCurrent = sPaused.back();
+	sPaused.pop_back();
+	sLastEntered[sCurrent] = ++sEntries;
+	sScenes[sCurrent]->OnResume();
+}
+
+bool Scene::DrawUnderlay(const Color& tint)
+{
+	if (sPaused.empty() || sUnderlayTarget == nullptr) return false;
+	DrawTexture(sUnderlayTarget, { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT }, SCREEN, 0.0f, tint);
+	return true;
+}
+
+void Scene::SetResidentLimit(size_t limit)
+{
+	sResidentLimit = std::max<size_t>(limit, 1);
+	Evict();
+}
+
+Scene* Scene::Create(Type type)
+{
+	switch (type)
+	{
+	case TITLE:
+		return new TitleScene;
+	case GAME:
+		return new GameScene;
+	case LAB_1A:
+		return new Lab1AScene;
+	case LAB_1B:
+		return new Lab1BScene;
+	case LAB_2:
+		return new Lab2Scene;
+	case LOSE:
+		return new LoseScene;
+	case PAUSE:
+		return new PauseScene;
+	case ASTEROIDS:
+		return new AsteroidsScene;
+	default:
+		assert(false);
+		return nullptr;
+	}
+}
+
+void Scene::Evict()
+{
+	size_t resident = 0;
+	for (Scene* scene : sScenes)
+		resident += scene != nullptr;
+
+	while (resident > sResidentLimit)
+	{
+		// Destroy the least recently entered scene other than the current one (or the one being loaded)
+		size_t oldest = COUNT;
+		for (size_t i = 0; i < COUNT; i++)
+		{
+			if (sScenes[i] == nullptr || i == sCurrent || i == sNext) continue;
+			if (find(sPaused.begin(), sPaused.end(), (Type)i) != sPaused.end()) continue;
+			if (oldest == COUNT || sLastEntered[i] < sLastEntered[oldest])
+				oldest = i;
+		}
+
+		// Everything else resident is paused beneath the current scene
+		if (oldest == COUNT) break;
+
+		delete sScenes[oldest];
+		sScenes[oldest] = nullptr;
+		resident--;
+	}
 }
 
 TitleScene::TitleScene()
 {
-	mTitlebackground.tex = LoadTexture("../Assets/img/TitleBack.jpg");
-	mTitleText.tex = LoadTexture("../Assets/img/TitleScreen.png");
+	mTitlebackground.tex = LoadTextureAsync("../Assets/img/TitleBack.jpg");
+	mTitleText.tex = LoadTextureAsync("../Assets/img/TitleScreen.png");
 }
 
 TitleScene::~TitleScene()
 {
-	UnloadTexture(mTitlebackground.tex);
-	UnloadTexture(mTitleText.tex);
+	UnloadAsset(mTitlebackground.tex);
+	UnloadAsset(mTitleText.tex);
+}
+
+bool TitleScene::IsReady()
+{
+	return !IsLoading(mTitlebackground.tex) && !IsLoading(mTitleText.tex);
 }
 
 void TitleScene::OnEnter()
@@ -86,7 +301,7 @@ void TitleScene::OnUpdate(float dt)
 	}
 	if (IsKeyDown(SDL_SCANCODE_SPACE))
 	{
-		Change(ASTEROIDS);
+		Transition(ASTEROIDS, 0.5f);
 	}
 }
 
@@ -107,14 +322,19 @@ void OnTitleGui(void* data)
 
 LoseScene::LoseScene()
 {
-	mLosebackground.tex = LoadTexture("../Assets/img/TitleBack.jpg");
-	mLoseText.tex = LoadTexture("../Assets/img/LoseScreen.png");
+	mLosebackground.tex = LoadTextureAsync("../Assets/img/TitleBack.jpg");
+	mLoseText.tex = LoadTextureAsync("../Assets/img/LoseScreen.png");
 }
 
 LoseScene::~LoseScene()
 {
-	UnloadTexture(mLosebackground.tex);
-	UnloadTexture(mLoseText.tex);
+	UnloadAsset(mLosebackground.tex);
+	UnloadAsset(mLoseText.tex);
+}
+
+bool LoseScene::IsReady()
+{
+	return !IsLoading(mLosebackground.tex) && !IsLoading(mLoseText.tex);
 }
 
 void LoseScene::OnEnter()
@@ -137,11 +357,11 @@ void LoseScene::OnUpdate(float dt)
 {
 	if (IsKeyDown(SDL_SCANCODE_M))
 	{
-		Change(TITLE);
+		Transition(TITLE, 0.5f);
 	}
 	if (IsKeyDown(SDL_SCANCODE_R))
 	{
-		Change(ASTEROIDS);
+		Transition(ASTEROIDS, 0.5f);
 	}
 }
 
@@ -153,14 +373,19 @@ void LoseScene::OnRender()
 
 PauseScene::PauseScene()
 {
-	mPausebackground.tex = LoadTexture("../Assets/img/TitleBack.jpg");
-	mPauseText.tex = LoadTexture("../Assets/img/PauseScreen.png");
+	mPausebackground.tex = LoadTextureAsync("../Assets/img/TitleBack.jpg");
+	mPauseText.tex = LoadTextureAsync("../Assets/img/PauseScreen.png");
 }
 
 PauseScene::~PauseScene()
 {
-	UnloadTexture(mPausebackground.tex);
-	UnloadTexture(mPauseText.tex);
+	UnloadAsset(mPausebackground.tex);
+	UnloadAsset(mPauseText.tex);
+}
+
+bool PauseScene::IsReady()
+{
+	return !IsLoading(mPausebackground.tex) && !IsLoading(mPauseText.tex);
 }
 
 void PauseScene::OnEnter()
@@ -173,7 +398,7 @@ void PauseScene::OnEnter()
 	mPauseText.width = 1024.0f;
 	mPauseText.height = 768.0f;
 
-	pauseTimer = 120.0f;
+	pauseTimer = 2.0f;
 }
 
 void PauseScene::OnExit()
@@ -185,67 +410,56 @@ void PauseScene::OnUpdate(float dt)
 {
 	if (pauseTimer > 0)
 	{
-		pauseTimer = pauseTimer - 1.0f;
+		pauseTimer = pauseTimer - dt;
 	}
 	if (pauseTimer <= 0)
 	{
 		if (IsKeyDown(SDL_SCANCODE_P))
 		{
-			Change(ASTEROIDS);
+			Pop();
 		}
 		if (IsKeyDown(SDL_SCANCODE_M))
 		{
-			Change(TITLE);
+			Transition(TITLE, 0.5f);
 		}
 	}
 }
 
 void PauseScene::OnRender()
 {
-	mPausebackground.Draw();
+	// Dim the frozen game behind the pause text (the old full-screen background is only a fallback now)
+	if (!DrawUnderlay({ 96, 96, 96, 255 }))
+		mPausebackground.Draw();
 	mPauseText.Draw();
 }
 GameScene::GameScene()
 {
-	mShipTex = LoadTexture("../Assets/img/enterprise.png");
+	mShipSprite = LoadSprite("../Assets/img/enterprise.png");
 }
 
 GameScene::~GameScene()
 {
-	UnloadTexture(mShipTex);
+	UnloadSprite(mShipSprite);
 }
 
 void GameScene::OnEnter()
 {
 	SetGuiCallback(OnGameGui, this);
 
-	XMLDocument doc;
-	doc.LoadFile("Game.xml");
-
-	XMLElement* gameData = doc.FirstChildElement();
-	XMLElement* shipData = gameData->FirstChildElement();
-	shipData->QueryAttribute("x", &mShipRec.x);
-	shipData->QueryAttribute("y", &mShipRec.y);
-	shipData->QueryAttribute("w", &mShipRec.w);
-	shipData->QueryAttribute("h", &mShipRec.h);
-	shipData->QueryAttribute("speed", &mShipSpeed);
+	GameSave save;
+	if (LoadSave("Game", save))
+	{
+		mShipRec = save.ship;
+		mShipSpeed = save.speed;
+	}
 }
 
 void GameScene::OnExit()
 {
-	XMLDocument doc;
-	XMLNode* root = doc.NewElement("Game");
-	doc.InsertEndChild(root);
-
-	XMLElement* ship = doc.NewElement("Ship");
-	ship->SetAttribute("x", mShipRec.x);
-	ship->SetAttribute("y", mShipRec.y);
-	ship->SetAttribute("w", mShipRec.w);
-	ship->SetAttribute("h", mShipRec.h);
-	ship->SetAttribute("speed", mShipSpeed);
-	root->InsertEndChild(ship);
-
-	doc.SaveFile("Game.xml");
+	GameSave save;
+	save.ship = mShipRec;
+	save.speed = mShipSpeed;
+	QueueSnapshot("Game.snap", save);
 
 	SetGuiCallback(nullptr, nullptr);
 }
@@ -272,7 +486,7 @@ void GameScene::OnUpdate(float dt)
 
 void GameScene::OnRender()
 {
-	DrawTexture(mShipTex, mShipRec);
+	DrawSprite(mShipSprite, mShipRec);
 }
 
 void OnGameGui(void* data)
@@ -287,8 +501,8 @@ void OnGameGui(void* data)
 
 Lab1AScene::Lab1AScene()
 {
-	mTexEnterprise = LoadTexture("../Assets/img/enterprise.png");
-	mTexD7 = LoadTexture("../Assets/img/d7.png");
+	mEnterpriseSprite = LoadSprite("../Assets/img/enterprise.png");
+	mD7Sprite = LoadSprite("../Assets/img/d7.png");
 
 	for (size_t i = 0; i < mShips.size(); i++)
 	{
@@ -304,16 +518,16 @@ Lab1AScene::Lab1AScene()
 		ship.dir = { 1.0f, 1.0f };
 
 		if (i % 2 == 0)
-			ship.tex = mTexEnterprise;
+			ship.sprite = mEnterpriseSprite;
 		else
-			ship.tex = mTexD7;
+			ship.sprite = mD7Sprite;
 	}
 }
 
 Lab1AScene::~Lab1AScene()
 {
-	UnloadTexture(mTexD7);
-	UnloadTexture(mTexEnterprise);
+	UnloadSprite(mD7Sprite);
+	UnloadSprite(mEnterpriseSprite);
 }
 
 void Lab1AScene::OnUpdate(float dt)
@@ -341,7 +555,7 @@ void Lab1AScene::OnUpdate(float dt)
 void Lab1AScene::OnRender()
 {
 	for (const Ship& ship : mShips)
-		DrawTexture(ship.tex, ship.rec);
+		DrawSprite(ship.sprite, ship.rec);
 }
 
 void OnLab1BGui(void* data)
@@ -420,6 +634,21 @@ void Lab1BScene::OnRender()
 {
 }
 
+// Reads a pool's capacity from the <Pools> section of AstGame.xml
+static size_t PoolCapacity(const char* scene, const char* pool, unsigned int fallback)
+{
+	CachedDocument doc;
+	doc->LoadFile("AstGame.xml");
+
+	unsigned int capacity = fallback;
+	XMLElement* root = doc->FirstChildElement();
+	XMLElement* pools = root != nullptr ? root->FirstChildElement("Pools") : nullptr;
+	XMLElement* element = pools != nullptr ? pools->FirstChildElement(scene) : nullptr;
+	if (element != nullptr)
+		element->QueryAttribute(pool, &capacity);
+	return capacity;
+}
+
 Lab2Scene::Lab2Scene()
 {
 }
@@ -430,47 +659,31 @@ Lab2Scene::~Lab2Scene()
 
 void Lab2Scene::OnEnter()
 {
-	XMLDocument doc;
-	doc.LoadFile("Turrets.xml");
-
-	XMLElement* element = doc.FirstChildElement();
-	while (element != nullptr)
+	mTurrets.Reserve(PoolCapacity("Lab2Scene", "turrets", 1024));
+	mEnemies.Reserve(PoolCapacity("Lab2Scene", "enemies", 1024));
+	mBullets.Reserve(PoolCapacity("Lab2Scene", "bullets", 4096));
+	SetGuiCallback(OnLab2Gui, this);
+
+	Lab2Save save;
+	LoadSave("Turrets", save);
+	for (const TurretSave& saved : save.turrets)
 	{
-		int kills = 0;
-		float cooldown = 1.0f;
-		Rect rec;
-		element->QueryAttribute("kills", &kills);
-		element->QueryAttribute("cooldown", &cooldown);
-		element->QueryAttribute("x", &rec.x);
-		element->QueryAttribute("y", &rec.y);
-		element->QueryAttribute("w", &rec.w);
-		element->QueryAttribute("h", &rec.h);
-		
 		Turret turret;
-		turret.rec = rec;
-		turret.cooldown = cooldown;
-		turret.kills = kills;
-		mTurrets.push_back(turret);
-
-		element = element->NextSiblingElement();
+		turret.rec = saved.rec;
+		turret.cooldown = saved.cooldown;
+		turret.kills = saved.kills;
+		mTurrets.Add(turret);
 	}
 }
 
 void Lab2Scene::OnExit()
 {
-	XMLDocument doc;
+	Lab2Save save;
+	save.turrets.reserve(mTurrets.Count());
 	for (const Turret& turret : mTurrets)
-	{
-		XMLElement* element = doc.NewElement("Turret");
-		element->SetAttribute("x", turret.rec.x);
-		element->SetAttribute("y", turret.rec.y);
-		element->SetAttribute("w", turret.rec.w);
-		element->SetAttribute("h", turret.rec.h);
-		element->SetAttribute("kills", turret.kills);
-		element->SetAttribute("cooldown", turret.cooldown);
-		doc.InsertEndChild(element);
-	}
-	doc.SaveFile("Turrets.xml");
+		save.turrets.push_back({ turret.rec, turret.cooldown, turret.kills });
+	QueueSnapshot("Turrets.snap", save);
+	SetGuiCallback(nullptr, nullptr);
 }
 
 void Lab2Scene::OnUpdate(float dt)
@@ -482,11 +695,12 @@ void Lab2Scene::OnUpdate(float dt)
 		turret.rec.y = rand() % SCREEN_HEIGHT;
 		turret.rec.w = 100.0f;
 		turret.rec.h = 100.0f;
-		mTurrets.push_back(turret);
+		mTurrets.Add(turret);
 	}
 
-	if (IsKeyPressed(SDL_SCANCODE_R))
-		mTurrets.pop_back();
+	// Bullets in flight keep a handle to their turret, so removing it is safe
+	if (IsKeyPressed(SDL_SCANCODE_R) && mTurrets.Count() > 0)
+		mTurrets.RemoveAt(mTurrets.Count() - 1);
 
 	if (IsKeyPressed(SDL_SCANCODE_E))
 	{
@@ -495,44 +709,39 @@ void Lab2Scene::OnUpdate(float dt)
 		enemy.rec.y = rand() % SCREEN_HEIGHT;
 		enemy.rec.w = 60.0f;
 		enemy.rec.h = 40.0f;
-		mEnemies.push_back(enemy);
+		mEnemies.Add(enemy);
 	}
 
-	for (Turret& turret : mTurrets)
+	mFiring.clear();
+	for (size_t i = 0; i < mTurrets.Count(); i++)
 	{
+		Turret& turret = mTurrets[i];
 		turret.cooldown -= dt;
 		if (turret.cooldown <= 0.0f)
 		{
 			turret.cooldown = 1.0f;
-
-			// Find the nearest enemy to shoot at:
-			float nearestDistance = FLT_MAX;
-			const Enemy* nearestEnemy = nullptr;
-
-			for (const Enemy& enemy : mEnemies)
-			{
-				float distance = DistanceSqr({ turret.rec.x, turret.rec.y }, { enemy.rec.x, enemy.rec.y });
-				if (distance < nearestDistance)
-				{
-					nearestDistance = distance;
-					nearestEnemy = &enemy;
-				}
-			}
-
-			if (nearestEnemy != nullptr)
-			{
-				// AB = B - A
-				Bullet bullet;
-				bullet.rec.w = 10.0f;
-				bullet.rec.h = 10.0f;
-				bullet.direction = Normalize({ nearestEnemy->rec.x - turret.rec.x, nearestEnemy->rec.y - turret.rec.y });
-				bullet.rec.x = turret.rec.x + turret.rec.w * bullet.direction.x;
-				bullet.rec.y = turret.rec.y + turret.rec.h * bullet.direction.y;
-				bullet.parent = &turret;
-				mBullets.push_back(bullet);
-			}
+			mFiring.push_back(i);
 		}
 	}
+
+	// Find the nearest enemy to shoot at for every turret that fired at once
+	FindTargets();
+	for (size_t i = 0; i < mFiring.size(); i++)
+	{
+		if (mTargets[i] < 0) continue;
+		const Turret& turret = mTurrets[mFiring[i]];
+		const Enemy& enemy = mEnemies[mTargets[i]];
+
+		// AB = B - A
+		Bullet bullet;
+		bullet.rec.w = 10.0f;
+		bullet.rec.h = 10.0f;
+		bullet.direction = Normalize({ enemy.rec.x - turret.rec.x, enemy.rec.y - turret.rec.y });
+		bullet.rec.x = turret.rec.x + turret.rec.w * bullet.direction.x;
+		bullet.rec.y = turret.rec.y + turret.rec.h * bullet.direction.y;
+		bullet.parent = mTurrets.HandleAt(mFiring[i]);
+		mBullets.Add(bullet);
+	}
 	
 	for (Bullet& bullet : mBullets)
 	{
@@ -542,36 +751,69 @@ void Lab2Scene::OnUpdate(float dt)
 	}
 
 	// Remove if colliding with enemy or off-screen
-	mBullets.erase(remove_if(mBullets.begin(), mBullets.end(),
-		[this](const Bullet& bullet)
+	for (size_t i = 0; i < mBullets.Count();)
+	{
+		const Bullet& bullet = mBullets[i];
+
+		// Check if the bullet is on-screen before checking it against every enemy
+		bool remove = !SDL_HasIntersectionF(&bullet.rec, &SCREEN);
+		for (size_t j = 0; j < mEnemies.Count() && !remove; j++)
 		{
-			// Check if the bullet is on-screen before checking it against every enemy
-			Rect screen{ 0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
-			if (!SDL_HasIntersectionF(&bullet.rec, &screen)) return true;
-	
-			for (Enemy& enemy : mEnemies)
+			Enemy& enemy = mEnemies[j];
+			if (SDL_HasIntersectionF(&bullet.rec, &enemy.rec))
 			{
-				if (SDL_HasIntersectionF(&bullet.rec, &enemy.rec))
-				{
-					enemy.health -= bullet.damage;
-					if (enemy.health <= 0.0f)
-						bullet.parent->kills++;
-					return true;
-				}
+				enemy.health -= bullet.damage;
+				Turret* parent = mTurrets.Get(bullet.parent);
+				if (enemy.health <= 0.0f && parent != nullptr)
+					parent->kills++;
+				remove = true;
 			}
-	
-			// Bullet is on-screen and not colliding with any enemies
-			return false;
-		}),
-	mBullets.end());
+		}
+
+		// Removing swaps the last bullet into i, so only advance if this one stays
+		if (remove)
+			mBullets.RemoveAt(i);
+		else
+			i++;
+	}
 
 	// Remove dead enemies
-	mEnemies.erase(remove_if(mEnemies.begin(), mEnemies.end(),
-		[this](const Enemy& enemy)
+	for (size_t i = 0; i < mEnemies.Count();)
+	{
+		if (mEnemies[i].health <= 0.0f)
+			mEnemies.RemoveAt(i);
+		else
+			i++;
+	}
+}
+
+void Lab2Scene::FindTargets()
+{
+	PROFILE_SCOPE("Targeting");
+
+	// Enemies are indexed by their top-left corner (the point targeting measures to)
+	mEnemyGrid.Clear();
+	for (int i = 0; i < (int)mEnemies.Count(); i++)
+		mEnemyGrid.Insert(i, { mEnemies[i].rec.x, mEnemies[i].rec.y, 0.0f, 0.0f });
+
+	// Answered in one batch on this thread. Each ring search only visits a few cells, which is cheaper than starting threads.
+	mTargets.resize(mFiring.size());
+	for (size_t i = 0; i < mFiring.size(); i++)
+	{
+		const Point turret{ mTurrets[mFiring[i]].rec.x, mTurrets[mFiring[i]].rec.y };
+		mTargets[i] = mEnemyGrid.Nearest(turret, [&](int id)
 		{
-			return enemy.health <= 0.0f;
-		}),
-	mEnemies.end());
+			return DistanceSqr(turret, { mEnemies[id].rec.x, mEnemies[id].rec.y });
+		});
+	}
+}
+
+void OnLab2Gui(void* data)
+{
+	Lab2Scene& scene = *(Lab2Scene*)data;
+	PoolGui("Turrets", scene.mTurrets.Usage());
+	PoolGui("Enemies", scene.mEnemies.Usage());
+	PoolGui("Bullets", scene.mBullets.Usage());
 }
 
 void Lab2Scene::OnRender()
@@ -589,25 +831,24 @@ void Lab2Scene::OnRender()
 AsteroidsScene::AsteroidsScene()
 {
 	
-	mShip.tex = LoadTexture("../Assets/img/enterprise.png");
-	sfxPlayerShoot = LoadSound("../Assets/aud/Fire.wav");
-	bgmDefault = LoadMusic("../Assets/aud/bgm.mp3");
-	sfxShipHit = LoadSound("../Assets/aud/Explode.wav");
-	if (bgmDefault == NULL)
-	{
-		std::cout << "Mix_LoadMUS failed to load file: " << SDL_GetError() << std::endl;
-	}
-	PlayMusic(bgmDefault, 1);
-	mBackground.texBackground = LoadTexture("../Assets/img/background.png");
+	mShip.sprite = LoadSprite("../Assets/img/enterprise.png");
+	mBulletSprite = LoadSprite("../Assets/img/bolt.png");
+	mAsteroidSprite = LoadSprite("../Assets/img/asteriod.png");
+	sfxPlayerShoot = LoadSoundAsync("../Assets/aud/Fire.wav");
+	bgmDefault = LoadMusicAsync("../Assets/aud/bgm.mp3");
+	sfxShipHit = LoadSoundAsync("../Assets/aud/Explode.wav");
+	mBackground.texBackground = LoadTextureAsync("../Assets/img/background.png");
 }
 
 AsteroidsScene::~AsteroidsScene()
 {
-	UnloadTexture(mBackground.texBackground);
-	UnloadTexture(mShip.tex);
-	UnloadMusic(bgmDefault);
-	UnloadSound(sfxPlayerShoot);
-	UnloadSound(sfxShipHit);
+	UnloadAsset(mBackground.texBackground);
+	UnloadSprite(mShip.sprite);
+	UnloadSprite(mBulletSprite);
+	UnloadSprite(mAsteroidSprite);
+	UnloadAsset(bgmDefault);
+	UnloadAsset(sfxPlayerShoot);
+	UnloadAsset(sfxShipHit);
 }
 
 void AsteroidsScene::OnEnter()
@@ -616,81 +857,103 @@ void AsteroidsScene::OnEnter()
 	mBackground.width = 1024.0f;
 	mBackground.height = 768.0f;
 
+	mBullets.Reserve(PoolCapacity("AsteroidsScene", "bullets", 256));
+	mAsteroids.Reserve(PoolCapacity("AsteroidsScene", "asteroids", 1024));
+	SetGuiCallback(OnAsteroidsGui, this);
 
-    XMLDocument doc;
-    doc.LoadFile("AstGame.xml");
-    
-    XMLElement* gameData = doc.FirstChildElement();
-    XMLElement* shipData = gameData->FirstChildElement();
-    shipData->QueryAttribute("x", &mShip.mShipRec.x);
-    shipData->QueryAttribute("y", &mShip.mShipRec.y);
-	shipData->QueryAttribute("w", &mShip.width);
-	shipData->QueryAttribute("w", &mShip.height);
-	shipData->QueryAttribute("h", &mShip.mShipRec.w);
-	shipData->QueryAttribute("h", &mShip.mShipRec.h);
-    shipData->QueryAttribute("speed", &mShip.speed);
-	shipData->QueryAttribute("angspeed", &mShip.angularSpeed);
-	shipData->QueryAttribute("bulletcooldownduration", &mShip.bulletCooldown.duration);
-	shipData->QueryAttribute("xPosition", &mShip.position.x);
-	shipData->QueryAttribute("yPosition", &mShip.position.y);
-
-	XMLElement* astData = gameData->FirstChildElement("Ast");
-	astData->QueryAttribute("timerElasped", &mAsteroidTimer.elapsed);
-	astData->QueryAttribute("timerDuration", &mAsteroidTimer.duration);
+	// Use the save loaded by OnPreload if there was a transition, otherwise load it now
+	const bool loaded = mPreload.valid() ? mPreload.get() : LoadSave("AstGame", mPreloadedSave);
+	if (loaded)
+	{
+		const AsteroidsSave& save = mPreloadedSave;
+		mShip.mShipRec.x = save.ship.x;
+		mShip.mShipRec.y = save.ship.y;
+		mShip.width = save.ship.w;
+		mShip.height = save.ship.h;
+		mShip.mShipRec.w = save.ship.w;
+		mShip.mShipRec.h = save.ship.h;
+		mShip.speed = save.speed;
+		mShip.angularSpeed = save.angularSpeed;
+		mShip.bulletCooldown.duration = save.bulletCooldown;
+		mShip.position = save.position;
+		mAsteroidTimer.elapsed = save.timerElapsed;
+		mAsteroidTimer.duration = save.timerDuration;
+	}
 
 	mShip.velocity = { 0,0 };
+	mShip.previousPosition = mShip.position;
 
-	pauseTimer = 120.0f;
+	pauseTimer = 2.0f;
 }
 
 void AsteroidsScene::OnExit()
 {
-	XMLDocument doc;
-	XMLNode* root = doc.NewElement("AstGame");
-	doc.InsertEndChild(root);
-
-	XMLElement* ship = doc.NewElement("Ship");
-	ship->SetAttribute("x", mShip.mShipRec.x);
-	ship->SetAttribute("y", mShip.mShipRec.y);
-	ship->SetAttribute("w", mShip.mShipRec.w);
-	ship->SetAttribute("h", mShip.mShipRec.h);
-	ship->SetAttribute("speed", mShip.speed);
-	ship->SetAttribute("angspeed", mShip.angularSpeed);
-	ship->SetAttribute("bulletcooldownduration", mShip.bulletCooldown.duration);
-	ship->SetAttribute("xPosition", mShip.position.x);
-	ship->SetAttribute("yPosition", mShip.position.y);
-	root->InsertEndChild(ship);
-
-	XMLElement* ast = doc.NewElement("Ast");
-	ast->SetAttribute("timerElasped", mAsteroidTimer.elapsed);
-	ast->SetAttribute("timerDuration", mAsteroidTimer.duration);
-	root->InsertEndChild(ast);
-
-	doc.SaveFile("AstGame.xml");
+	AsteroidsSave save;
+	save.ship = mShip.mShipRec;
+	save.speed = mShip.speed;
+	save.angularSpeed = mShip.angularSpeed;
+	save.bulletCooldown = mShip.bulletCooldown.duration;
+	save.position = mShip.position;
+	save.timerElapsed = mAsteroidTimer.elapsed;
+	save.timerDuration = mAsteroidTimer.duration;
+	QueueSnapshot("AstGame.snap", save);
 	SetGuiCallback(nullptr, nullptr);
 }
 
+void AsteroidsScene::OnPreload()
+{
+	if (mPreload.valid()) return;
+	mPreload = async(launch::async, [this] { return LoadSave("AstGame", mPreloadedSave); });
+}
+
+void AsteroidsScene::OnResume()
+{
+	// Pausing exited nothing, so only restore what PauseScene changed
+	pauseTimer = 2.0f;
+	SetGuiCallback(OnAsteroidsGui, this);
+}
+
+bool AsteroidsScene::IsReady()
+{
+	// Sounds & music can finish after the scene starts, but the background shouldn't pop in
+	const bool parsed = !mPreload.valid() || mPreload.wait_for(chrono::seconds(0)) == future_status::ready;
+	return parsed && !IsLoading(mBackground.texBackground);
+}
+
 void AsteroidsScene::OnUpdate(float dt)
 {
+	ProfileBegin("Ship");
+
+	if (!mMusicStarted && GetMusic(bgmDefault) != nullptr)
+	{
+		PlayMusic(GetMusic(bgmDefault), 1);
+		mMusicStarted = true;
+	}
+
+	// Remember where everything was so rendering can interpolate towards where it ends up this tick
+	mShip.previousPosition = mShip.position;
+	mBullets.previousPositions = mBullets.positions;
+	mAsteroids.previousPositions = mAsteroids.positions;
+
 	mShip.mShipRec = mShip.Collider();
 	mShip.velocity.x = mShip.direction.x * mShip.speed;
 	mShip.velocity.y = mShip.direction.y * mShip.speed;
 	//Cooldowns
 	if (mShip.damageCooldown > 0)
 	{
-		mShip.damageCooldown = mShip.damageCooldown - 1;
+		mShip.damageCooldown = mShip.damageCooldown - dt;
 	}
 	if (mShip.knockbackCooldown > 0)
 	{
-		mShip.knockbackCooldown = mShip.knockbackCooldown - 1;
+		mShip.knockbackCooldown = mShip.knockbackCooldown - dt;
 	}
 	if (mShip.collsionDelay > 0)
 	{
-		mShip.collsionDelay = mShip.collsionDelay - 1;
+		mShip.collsionDelay = mShip.collsionDelay - dt;
 	}
 	if (pauseTimer > 0)
 	{
-		pauseTimer = pauseTimer - 1.0f;
+		pauseTimer = pauseTimer - dt;
 	} 
 
 
@@ -708,14 +971,14 @@ void AsteroidsScene::OnUpdate(float dt)
 	{	
 		if (mShip.acceleration.x < 0.5)
 		{
-			mShip.acceleration.x += 0.005f;
+			mShip.acceleration.x += 0.3f * dt;
 		}
 	}
 	else
 	{
 		if (mShip.acceleration.x > 0)
 		{
-			mShip.acceleration.x -= 0.009f;
+			mShip.acceleration.x -= 0.54f * dt;
 		}
 		else if (mShip.acceleration.x < 0)
 		{
@@ -727,7 +990,7 @@ void AsteroidsScene::OnUpdate(float dt)
 	{	
 		if (mShip.acceleration.x > 0)
 		{
-			mShip.acceleration.x -= 0.04f;
+			mShip.acceleration.x -= 2.4f * dt;
 		}
 		else if (mShip.acceleration.x < 0)
 		{
@@ -739,7 +1002,7 @@ void AsteroidsScene::OnUpdate(float dt)
 	{
 		if (IsKeyDown(SDL_SCANCODE_P))
 		{
-			Change(PAUSE);
+			Push(PAUSE);
 		}
 	}
 	if (IsKeyDown(SDL_SCANCODE_SPACE))
@@ -748,79 +1011,44 @@ void AsteroidsScene::OnUpdate(float dt)
 		{
 			mShip.bulletCooldown.Reset();
 
-			Bullet bullet;
-			bullet.width = bullet.height = 50.0f;
-			bullet.position = mShip.position + mShip.direction * sqrtf(powf(mShip.width * 0.5f + bullet.width * 0.5f, 2.0f));
-			bullet.velocity = mShip.direction * 500.0f;
-			bullet.direction = mShip.direction;
-			mBullets.push_back(bullet);
+			const float offset = sqrtf(powf(mShip.width * 0.5f + mBulletSize * 0.5f, 2.0f));
+			mBullets.Add(mShip.position + mShip.direction * offset, mShip.direction * 500.0f);
 
-			PlaySound(sfxPlayerShoot, 0);
+			PlaySound(GetSound(sfxPlayerShoot), 0);
 		}
 	}
 
 	mShip.bulletCooldown.Tick(dt);
 
+	// Ship speed is in pixels per 60th of a second
 	if (mShip.collsionDelay <= 0)
 	{
-		mShip.position.x += (mShip.velocity.x * mShip.acceleration.x);
-		mShip.position.y += (mShip.velocity.y * mShip.acceleration.x);
+		mShip.position.x += (mShip.velocity.x * mShip.acceleration.x) * 60.0f * dt;
+		mShip.position.y += (mShip.velocity.y * mShip.acceleration.x) * 60.0f * dt;
 	}
+	ProfileEnd();
+
 	//Asteriod Collision
-	for (Asteroid& asteroid : mAsteroidsLarge)
-	{
-		Rect asteroidRect = asteroid.Collider();
-		Rect shipRect = mShip.Collider();
-		if (SDL_HasIntersectionF(&shipRect, &asteroidRect))
-		{
-			if (SDL_HasIntersectionF(&shipRect, &asteroidRect))
-			{
-				mShip.velocity.x = 0;
-				mShip.velocity.y = 0;
-				mShip.acceleration.x = 0;
-				mShip.collsionDelay = 10.0f;
-			}
-			if (mShip.damageCooldown <= 0)
-			{
-				//damage
-				mShip.damageCooldown = 60.0f;
-				mShip.health = mShip.health - asteroid.damage;
-				//sound
-				PlaySound(sfxShipHit, 0);
-			}
-			//knockback
-			if (mShip.knockbackCooldown <= 0)
-			{
-				float r = 180.0f * DEG2RAD;
-				float v = Random(100.0f, 200.0f);
-				Point direction = Normalize(asteroid.velocity);
-				Point direction1 = Rotate(direction, r);
-				asteroid.velocity = direction1 * v;
-				mShip.knockbackCooldown = 20.0f;
-			}
-		}
-	}
-	for (Asteroid& asteroid : mAsteroidsMedium)
+	ProfileBegin("Ship Collision");
+	BuildGrid();
+	Rect shipRect = mShip.Collider();
+	mGrid.Query(shipRect, [&](int id)
 	{
-		Rect asteroidRect = asteroid.Collider();
-		Rect shipRect = mShip.Collider();
+		Rect asteroidRect = mAsteroids.Collider(id);
 		if (SDL_HasIntersectionF(&shipRect, &asteroidRect))
 		{
-			if (SDL_HasIntersectionF(&shipRect, &asteroidRect))
-			{
-				mShip.velocity.x = 0;
-				mShip.velocity.y = 0;
-				mShip.acceleration.x = 0;
-				mShip.collsionDelay = 10.0f;
+			mShip.velocity.x = 0;
+			mShip.velocity.y = 0;
+			mShip.acceleration.x = 0;
+			mShip.collsionDelay = 10.0f / 60.0f;
 
-			}
 			if (mShip.damageCooldown <= 0)
 			{
 				//damage
-				mShip.damageCooldown = 60.0f;
-				mShip.health = mShip.health - asteroid.damage;
+				mShip.damageCooldown = 1.0f;
+				mShip.health = mShip.health - mAsteroidDamage;
 				//sound
-				PlaySound(sfxShipHit, 0);
+				PlaySound(GetSound(sfxShipHit), 0);
 			}
 
 			//knockback
@@ -828,175 +1056,117 @@ void AsteroidsScene::OnUpdate(float dt)
 			{
 				float r = 180.0f * DEG2RAD;
 				float v = Random(100.0f, 200.0f);
-				Point direction = Normalize(asteroid.velocity);
+				Point direction = Normalize(mAsteroids.velocities[id]);
 				Point direction1 = Rotate(direction, r);
-				asteroid.velocity = direction1 * v; 
-				mShip.knockbackCooldown = 60.0f;
+				mAsteroids.velocities[id] = direction1 * v;
+				mShip.knockbackCooldown = mAsteroids.sizes[id] == LARGE ? 20.0f / 60.0f : 1.0f;
 			}
 		}
-	}
-	for (Asteroid& asteroid : mAsteroidsSmall)
-	{
-		Rect asteroidRect = asteroid.Collider();
-		Rect shipRect = mShip.Collider();
-		if (SDL_HasIntersectionF(&shipRect, &asteroidRect))
-		{
-			if (SDL_HasIntersectionF(&shipRect, &asteroidRect))
-			{
-				mShip.velocity.x = 0;
-				mShip.velocity.y = 0;
-				mShip.acceleration.x = 0;
-				mShip.collsionDelay = 10.0f;
+	});
+	ProfileEnd();
 
-			}
-			if (mShip.damageCooldown <= 0)
-			{
-				//damage
-				mShip.damageCooldown = 60.0f;
-				mShip.health = mShip.health - asteroid.damage;
-				//sound
-				PlaySound(sfxShipHit, 0);
-			}
-
-			//knockback
-			if (mShip.knockbackCooldown <= 0)
-			{
-				float r = 180.0f * DEG2RAD;
-				float v = Random(100.0f, 200.0f);
-				Point direction = Normalize(asteroid.velocity);
-				Point direction1 = Rotate(direction, r);
-				asteroid.velocity = direction1 * v;
-				mShip.knockbackCooldown = 60.0f;
-			}
-		}
-	}
 	//Tint
 	if (mShip.health < 75.0f && mShip.health > 50.0f)
 	{
-		Tint(mShip.tex, mShip.col3);
+		mShip.tint = mShip.col3;
 	}
 	if (mShip.health < 50.0f && mShip.health > 25.0f)
 	{
-		Tint(mShip.tex, mShip.col2);
+		mShip.tint = mShip.col2;
 	}
 	if (mShip.health < 25.0f && mShip.health > 0.0f)
 	{
-		Tint(mShip.tex, mShip.col1);
+		mShip.tint = mShip.col1;
 	}
 	//Death
 	if (mShip.health <= 0)
 	{
-		UnloadTexture(mShip.tex);
-		mShip.tex = LoadTexture("../Assets/img/explosion.png");
-		mShip.deathDelay++;
-		if (mShip.deathDelay >= 40.0f)
+		if (mShip.deathDelay <= 0.0f)
 		{
-			while (!mAsteroidsLarge.empty()) 
-			{
-				mAsteroidsLarge.pop_back();
-			}
-			while (!mAsteroidsMedium.empty()) 
-			{
-				mAsteroidsMedium.pop_back();
-			}
-			while (!mAsteroidsSmall.empty()) 
-			{
-				mAsteroidsSmall.pop_back();
-			}
+			// Swap to the explosion on the first tick of death only
+			UnloadSprite(mShip.sprite);
+			mShip.sprite = LoadSprite("../Assets/img/explosion.png");
+		}
+		mShip.deathDelay += dt;
+		if (mShip.deathDelay >= 40.0f / 60.0f)
+		{
+			// The grid still holds the cleared asteroids' ids, which the bullet loop below would look up
+			mAsteroids.Clear();
+			mGrid.Clear();
 			mShip.health = 100.0f;
-			mShip.position = { SCREEN_WIDTH * 0.5f, SCREEN_HEIGHT * 0.5f };
+			mShip.position = mShip.previousPosition = { SCREEN_WIDTH * 0.5f, SCREEN_HEIGHT * 0.5f };
 			mShip.direction = { 1.0f, 0.0f };
-			mShip.tex = LoadTexture("../Assets/img/enterprise.png");
-			Change(LOSE);
+			UnloadSprite(mShip.sprite);
+			mShip.sprite = LoadSprite("../Assets/img/enterprise.png");
+			mShip.tint = { 255, 255, 255, 255 };
+			mShip.deathDelay = 0.0f;
+			Transition(LOSE, 1.0f);
 		}
 		
 	}
-	for (Bullet& bullet : mBullets)
+	ProfileBegin("Bullets");
+	for (size_t i = 0; i < mBullets.Count(); i++)
+		mBullets.positions[i] = mBullets.positions[i] + mBullets.velocities[i] * dt;
+
+	for (size_t i = 0; i < mBullets.Count(); i++)
 	{
-		bullet.position = bullet.position + bullet.velocity * dt;
-		Rect bulletRect = bullet.Collider();
+		Rect bulletRect = BulletCollider(i);
 
-		// TODO -- spawn 2 medium asteroids if a bullet hits a large asteroid
-		for (Asteroid& asteroid : mAsteroidsLarge)
+		// Only test asteroids that share a grid cell with the bullet
+		mGrid.Query(bulletRect, [&](int id)
 		{
-			Rect asteroidRect = asteroid.Collider();
-			if (SDL_HasIntersectionF(&bulletRect, &asteroidRect))
-			{
-				asteroid.health -= bullet.damage;
-
-				Asteroid asteroid1, asteroid2;
-				asteroid1.position = asteroid2.position = asteroid.position;
-				asteroid1.width = asteroid2.width = mSizeMedium;
-				asteroid1.height = asteroid2.height = mSizeMedium;
-
-				float r = Random(30.0f, 45.0f) * DEG2RAD;
-				float v = Random(20.0f, 200.0f);
-				Point direction = Normalize(bullet.velocity);
-				Point direction1 = Rotate(direction, r);
-				Point direction2 = Rotate(direction, -r);
-				asteroid1.velocity = direction1 * v;
-				asteroid2.velocity = direction2 * v;
+			// Small asteroids don't split
+			const SizeClass sizeClass = mAsteroids.sizes[id];
+			if (sizeClass == SMALL) return;
+
+			Rect asteroidRect = mAsteroids.Collider(id);
+			if (!SDL_HasIntersectionF(&bulletRect, &asteroidRect)) return;
+
+			mAsteroids.health[id] -= mBulletDamage;
+
+			// Spawn 2 medium asteroids if a bullet hits a large asteroid, or 2 small asteroids if it hits a medium asteroid
+			const bool large = sizeClass == LARGE;
+			const float size = large ? mSizeMedium : mSizeSmall;
+			const float offset = large ? mSizeLarge : mSizeMedium;
+
+			float r = Random(30.0f, 45.0f) * DEG2RAD;
+			float v = Random(20.0f, 200.0f);
+			Point direction = Normalize(mBullets.velocities[i]);
+			Point direction1 = Rotate(direction, r);
+			Point direction2 = Rotate(direction, -r);
+
+			// TODO -- take bullet collider and velocity into account when spawning asteroids
+			// Copy the position since adding writes to the same arrays
+			const Point position = mAsteroids.positions[id];
+			const SizeClass split = large ? MEDIUM : SMALL;
+			mAsteroids.Add(position + direction1 * offset, direction1 * v, size, split);
+			mAsteroids.Add(position + direction2 * offset, direction2 * v, size, split);
+		});
+	}
 
-				// TODO -- take bullet collider and velocity into account when spawning asteroids
-				asteroid1.position = asteroid1.position + direction1 * mSizeLarge;
-				asteroid2.position = asteroid2.position + direction2 * mSizeLarge;
+	ProfileEnd();
 
-				mAsteroidsMedium.push_back(asteroid1);
-				mAsteroidsMedium.push_back(asteroid2);
-			}
+	// Integrate then wrap. Plain loops over contiguous arrays so the compiler can vectorize them
+	{
+		PROFILE_SCOPE("Integrate");
+		const size_t count = mAsteroids.Count();
+		Point* positions = mAsteroids.positions.data();
+		const Point* velocities = mAsteroids.velocities.data();
+		for (size_t i = 0; i < count; i++)
+		{
+			positions[i].x += velocities[i].x * dt;
+			positions[i].y += velocities[i].y * dt;
 		}
 
-		// Spawn 2 small asteroids if a bullet hits a medium asteroid
-		for (Asteroid& asteroid : mAsteroidsMedium)
+		for (size_t i = 0; i < count; i++)
 		{
-			Rect asteroidRect = asteroid.Collider();
-			if (SDL_HasIntersectionF(&bulletRect, &asteroidRect))
-			{
-				asteroid.health -= bullet.damage;
-
-				Asteroid asteroid1, asteroid2;
-				asteroid1.position = asteroid2.position = asteroid.position;
-				asteroid1.width = asteroid2.width = mSizeSmall;
-				asteroid1.height = asteroid2.height = mSizeSmall;
-
-				float r = Random(30.0f, 45.0f) * DEG2RAD;
-				float v = Random(20.0f, 200.0f);
-				Point direction = Normalize(bullet.velocity);
-				Point direction1 = Rotate(direction,  r);
-				Point direction2 = Rotate(direction, -r);
-				asteroid1.velocity = direction1 * v;
-				asteroid2.velocity = direction2 * v;
-
-				// TODO -- take bullet collider and velocity into account when spawning asteroids
-				asteroid1.position = asteroid1.position + direction1 * mSizeMedium;
-				asteroid2.position = asteroid2.position + direction2 * mSizeMedium;
-
-				mAsteroidsSmall.push_back(asteroid1);
-				mAsteroidsSmall.push_back(asteroid2);
-			}
+			const float x = positions[i].x;
+			const float y = positions[i].y;
+			positions[i].x = x <= 0.0f ? SCREEN_WIDTH : (x >= SCREEN_WIDTH ? 0.0f : x);
+			positions[i].y = y <= 0.0f ? SCREEN_HEIGHT : (y >= SCREEN_HEIGHT ? 0.0f : y);
 		}
 	}
 
-	// TODO -- update and wrap large asteroids. Consider making a physics update function like in AI
-
-	for (Asteroid& asteroid : mAsteroidsLarge)
-	{
-		asteroid.position = asteroid.position + asteroid.velocity * dt;
-		Wrap(asteroid);
-	}
-
-	for (Asteroid& asteroid : mAsteroidsMedium)
-	{
-		asteroid.position = asteroid.position + asteroid.velocity * dt;
-		Wrap(asteroid);
-	}
-
-	for (Asteroid& asteroid : mAsteroidsSmall)
-	{
-		asteroid.position = asteroid.position + asteroid.velocity * dt;
-		Wrap(asteroid);
-	}
-
 	Wrap(mShip);
 
 	//static float tt = 0.0f;
@@ -1010,7 +1180,7 @@ void AsteroidsScene::OnUpdate(float dt)
 	if (mAsteroidTimer.Expired())
 	{
 		mAsteroidTimer.Reset();
-		mAsteroidsLarge.push_back(SpawnAsteroid(mSizeLarge));
+		SpawnAsteroid(mSizeLarge);
 	}
 	mAsteroidTimer.Tick(dt);
 
@@ -1018,90 +1188,81 @@ void AsteroidsScene::OnUpdate(float dt)
 	// Bullet collision - remove if off screen or hitting asteroid
 	// Handle small vs medium asteroids accordingly
 	// Hint: small.direction = Rotate(medium.direction, Random(30.0f, 45.0f) * DEG2RAD * dt);
-	mBullets.erase(remove_if(mBullets.begin(), mBullets.end(), [this](Bullet& bullet)
+	// Asteroids have moved and split since the grid was built
+	PROFILE_SCOPE("Cleanup");
+	BuildGrid();
+	for (size_t i = 0; i < mBullets.Count();)
 	{
-			// Test if bullet is off-screen first because that's cheaper than testing it against every asteroid
-			Rect bulletRect = bullet.Collider();
-			if (!SDL_HasIntersectionF(&bulletRect, &SCREEN)) return true;
+		// Test if bullet is off-screen first because that's cheaper than testing it against every asteroid
+		Rect bulletRect = BulletCollider(i);
+		bool remove = !SDL_HasIntersectionF(&bulletRect, &SCREEN);
 
-			// Make this a function if you'd like to remove the duplication in these 3 loops
-			for (Asteroid& asteroid : mAsteroidsLarge)
-			{
-				Rect asteroidRect = asteroid.Collider();
-				if (SDL_HasIntersectionF(&asteroidRect, &bulletRect))
-				{
-					asteroid.health -= bullet.damage;
-					return true;
-				}
-			}
-
-			for (Asteroid& asteroid : mAsteroidsMedium)
+		// A bullet only damages one asteroid. Prefer large, then medium, then small (lowest index within a size)
+		int hit = -1;
+		if (!remove)
+		{
+			mGrid.Query(bulletRect, [&](int id)
 			{
-				Rect asteroidRect = asteroid.Collider();
-				if (SDL_HasIntersectionF(&asteroidRect, &bulletRect))
-				{
-					asteroid.health -= bullet.damage;
-					return true;
-				}
-			}
+				if (hit >= 0 && (mAsteroids.sizes[hit] < mAsteroids.sizes[id] ||
+					(mAsteroids.sizes[hit] == mAsteroids.sizes[id] && hit < id))) return;
 
-			for (Asteroid& asteroid : mAsteroidsSmall)
-			{
-				Rect asteroidRect = asteroid.Collider();
+				Rect asteroidRect = mAsteroids.Collider(id);
 				if (SDL_HasIntersectionF(&asteroidRect, &bulletRect))
-				{
-					asteroid.health -= bullet.damage;
-					return true;
-				}
-			}
-
-			return false;
-	}), mBullets.end());
+					hit = id;
+			});
+		}
 
-	mAsteroidsLarge.erase(remove_if(mAsteroidsLarge.begin(), mAsteroidsLarge.end(), [this](const Asteroid& asteroid)
-	{
-		mShip.score = mShip.score + 1;
-		return asteroid.health <= 0.0f;
-	}), mAsteroidsLarge.end());
+		if (hit >= 0)
+		{
+			mAsteroids.health[hit] -= mBulletDamage;
+			remove = true;
+		}
 
-	mAsteroidsMedium.erase(remove_if(mAsteroidsMedium.begin(), mAsteroidsMedium.end(), [this](const Asteroid& asteroid)
-	{
-		mShip.score = mShip.score + 1;
-		return asteroid.health <= 0.0f;
-	}), mAsteroidsMedium.end());
+		if (remove)
+			mBullets.Remove(i);
+		else
+			i++;
+	}
 
-	mAsteroidsSmall.erase(remove_if(mAsteroidsSmall.begin(), mAsteroidsSmall.end(), [this](const Asteroid& asteroid)
+	// Score goes up for every asteroid alive at the end of the frame
+	mShip.score += mAsteroids.Count();
+	for (size_t i = 0; i < mAsteroids.Count();)
 	{
-		mShip.score = mShip.score + 1;
-		return asteroid.health <= 0.0f;
-	}), mAsteroidsSmall.end());
+		if (mAsteroids.health[i] <= 0.0f)
+			mAsteroids.Remove(i);
+		else
+			i++;
+	}
 }
 
 void AsteroidsScene::OnRender()
 {
-	mBackground.Draw();
-	for (const Asteroid& asteroid : mAsteroidsLarge)
-	{
-		asteroid.Draw(); 
-	}
+	// Render between the last two simulation ticks
+	const float alpha = TickAlpha();
 
-	for (const Asteroid& asteroid : mAsteroidsMedium)
+	mBackground.Draw();
+	for (size_t i = 0; i < mAsteroids.Count(); i++)
 	{
-		asteroid.Draw();
+		const Point position = Interpolate(mAsteroids.previousPositions[i], mAsteroids.positions[i], alpha);
+		const float extent = mAsteroids.halfExtents[i];
+		const Rect rect{ position.x - extent, position.y - extent, extent * 2.0f, extent * 2.0f };
+		//DrawRect(rect, mAsteroidColor);
+		DrawSprite(mAsteroidSprite, rect);
+		DrawLine(position, position + Point{ 20.0f, 0.0f }, mAsteroidColor);
 	}
 
-	for (const Asteroid& asteroid : mAsteroidsSmall)
-	{
-		asteroid.Draw();
-	}
-		
-	for (const Bullet& bullet : mBullets)
+	for (size_t i = 0; i < mBullets.Count(); i++)
 	{
-		bullet.Draw();
+		const Point position = Interpolate(mBullets.previousPositions[i], mBullets.positions[i], alpha);
+		const Point direction = Normalize(mBullets.velocities[i]);
+		const Rect rect{ position.x - mBulletSize * 0.5f, position.y - mBulletSize * 0.5f, mBulletSize, mBulletSize };
+		//DrawRect(rect, mBulletColor);
+		DrawSprite(mBulletSprite, rect, Angle(direction) * RAD2DEG);
+		DrawLine(position, position + direction * 20.0f, mBulletColor);
 	}
 
 	//DrawRect({ 0, 0, 200, 200 }, mTestColor);
-	mShip.Draw();
+	mShip.Draw(Interpolate(mShip.previousPosition, mShip.position, alpha));
 	
 }
 
@@ -1114,20 +1275,38 @@ void AsteroidsScene::Wrap(Entity& entity)
 	else if (entity.position.y >= SCREEN_HEIGHT) entity.position.y = 0.0f;
 }
 
-AsteroidsScene::Asteroid AsteroidsScene::SpawnAsteroid(float size)
+void AsteroidsScene::BuildGrid()
 {
-	Asteroid asteroid;
-	asteroid.width = asteroid.height = size;
+	mGrid.Clear();
+	for (int i = 0; i < (int)mAsteroids.Count(); i++)
+		mGrid.Insert(i, mAsteroids.Collider(i));
+}
 
+Point AsteroidsScene::Interpolate(Point previous, Point current, float alpha)
+{
+	if (fabsf(current.x - previous.x) > SCREEN_WIDTH * 0.5f || fabsf(current.y - previous.y) > SCREEN_HEIGHT * 0.5f)
+		return current;
+	return Lerp(previous, current, alpha);
+}
+
+Rect AsteroidsScene::BulletCollider(size_t i) const
+{
+	const Point position = mBullets.positions[i];
+	return { position.x - mBulletSize * 0.5f, position.y - mBulletSize * 0.5f, mBulletSize, mBulletSize };
+}
+
+void AsteroidsScene::SpawnAsteroid(float size)
+{
 	// Ensure asteroid isn't spawned on top of player
+	Point position{};
 	bool collision = true;
 	while (collision)
 	{
-		float x = Random(0.0f, SCREEN_WIDTH - asteroid.width);
-		float y = Random(0.0f, SCREEN_HEIGHT - asteroid.height);
-		asteroid.position = { x, y };
+		float x = Random(0.0f, SCREEN_WIDTH - size);
+		float y = Random(0.0f, SCREEN_HEIGHT - size);
+		position = { x, y };
 
-		Rect asteroidRect = asteroid.Collider();
+		Rect asteroidRect{ x - size * 0.5f, y - size * 0.5f, size, size };
 		Rect shipRect = mShip.Collider();
 		shipRect.w *= 4.0f;
 		shipRect.h *= 4.0f;
@@ -1135,17 +1314,18 @@ AsteroidsScene::Asteroid AsteroidsScene::SpawnAsteroid(float size)
 	}
 
 	// Add some variance to asteroid movement by shooting them +- 10 degrees towards the player
-	Point toPlayer = Normalize(mShip.position - asteroid.position);
+	Point toPlayer = Normalize(mShip.position - position);
 	toPlayer = Rotate(toPlayer, Random(-10.0f, 10.0f) * DEG2RAD);
-	asteroid.velocity = toPlayer * Random(20.0f, 200.0f);
-
-	return asteroid;
+	mAsteroids.Add(position, toPlayer * Random(20.0f, 200.0f), size, LARGE);
 }
 
 void OnAsteroidsGui(void* data)
 {
 	AsteroidsScene& scene = *(AsteroidsScene*)data;
 
+	PoolGui("Bullets", scene.mBullets.Usage());
+	PoolGui("Asteroids", scene.mAsteroids.Usage());
+
 	static float colors[4]{ 1.0f, 1.0f, 1.0f, 1.0f };	// from 0 to 1
 	if (ImGui::ColorPicker4("Ship Color", colors))
 	{
@@ -1,7 +1,10 @@
 #pragma once
 #include "Core.h"
+#include "SpatialGrid.h"
 #include <array>
 #include <vector>
+#include "Saves.h"
+#include <future>
 constexpr int SCREEN_WIDTH = 1024;
 constexpr int SCREEN_HEIGHT = 768;
 constexpr Rect SCREEN = { 0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
@@ -10,6 +13,7 @@ void OnTitleGui(void* data);
 void OnGameGui(void* data);
 void OnLab1BGui(void* data);
 void OnAsteroidsGui(void* data);
+void OnLab2Gui(void* data);
 
 class Scene
 {
@@ -23,6 +27,17 @@ public:
 	virtual void OnUpdate(float dt) = 0;
 	virtual void OnRender() = 0;
 
+	// Called when a transition into this scene starts so it can begin loading in the background
+	virtual void OnPreload() {}
+
+	// Polled every update during a transition into this scene, which happens once it returns true
+	virtual bool IsReady() { return true; }
+
+	// Called when another scene is pushed on top of this one, and when that scene is popped off again.
+	// Paused scenes stay entered (no OnExit/OnEnter) but aren't updated or rendered.
+	virtual void OnPause() {}
+	virtual void OnResume() {}
+
 	enum Type : size_t
 	{
 		TITLE,
@@ -44,9 +59,44 @@ public:
 
 	static void Change(Type type);
 
+	// Changes scene once the next scene is ready (without stalling frames in the meantime), then fades the
+	// last frame of the current scene out over the next scene across fade seconds
+	static void Transition(Type type, float fade = 0.0f);
+
+	// Pauses the current scene and enters type on top of it once type is ready (like Transition, without a fade).
+	// Pop exits the top scene and resumes the one below. Change & Transition exit every scene on the stack.
+	static void Push(Type type);
+	static void Pop();
+
+	// Scenes are constructed (loading their assets) the first time they're entered. Once more than limit scenes
+	// exist, the least recently entered ones other than the current scene are destroyed to release their assets.
+	// Paused scenes are never evicted, so the limit is exceeded while they're on the stack. Defaults to COUNT (never evict).
+	static void SetResidentLimit(size_t limit);
+
+protected:
+	// Draws the last frame of the scene paused underneath (for overlays). Returns false if there isn't one.
+	static bool DrawUnderlay(const Color& tint = { 255, 255, 255, 255 });
+
 private:
+	static Scene* Create(Type type);
+	static void Evict();
+	static void FinishTransition();
+	static void FinishPush();
+
 	static Type sCurrent;
-	static std::array<Scene*, COUNT> sScenes;
+	static std::array<Scene*, COUNT> sScenes;		// nullptr until first entered or after eviction
+	static std::array<size_t, COUNT> sLastEntered;	// Value of sEntries when each scene was last entered
+	static size_t sEntries;
+	static size_t sResidentLimit;
+
+	static Type sNext;				// Scene being transitioned to or pushed (COUNT if none)
+	static bool sPushing;			// Whether sNext is entered on top of the current scene rather than replacing it
+	static float sFadeDuration;
+	static float sFade;				// Seconds of fade remaining
+	static Texture* sFadeTarget;	// Last frame of the previous scene
+
+	static std::vector<Type> sPaused;	// Scenes paused underneath the current scene (top last)
+	static Texture* sUnderlayTarget;	// Last frame of the most recently paused scene
 };
 
 class LoseScene : public Scene
@@ -61,6 +111,8 @@ public:
 	void OnUpdate(float dt) final;
 	void OnRender() final;
 
+	bool IsReady() final;
+
 private:
 	Rect mBackRec = { 0.0f, 0.0f, SCREEN_WIDTH, SCREEN_HEIGHT };
 	Rect mFrontRec = { 0.0f, 0.0f, 60.0f, 40.0f };
@@ -91,18 +143,18 @@ private:
 	{
 		void Draw() const
 		{
-			DrawTexture(tex, Collider(), 0);
+			DrawTexture(GetTexture(tex), Collider(), 0);	// Draws nothing until loaded
 		}
-		Texture* tex = LoadTexture("../Assets/img/TitleBack.jpg");
+		Handle tex;
 	}mLosebackground;
 
 	struct LoseText : public Entity
 	{
 		void Draw() const
 		{
-			DrawTexture(tex, Collider(), 0);
+			DrawTexture(GetTexture(tex), Collider(), 0);	// Draws nothing until loaded
 		}
-		Texture* tex = nullptr;
+		Handle tex;
 	}mLoseText;
 };
 
@@ -118,12 +170,14 @@ public:
 	void OnUpdate(float dt) final;
 	void OnRender() final;
 
+	bool IsReady() final;
+
 
 private:
 	Rect mBackRec = { 0.0f, 0.0f, SCREEN_WIDTH, SCREEN_HEIGHT };
 	Rect mFrontRec = { 0.0f, 0.0f, 60.0f, 40.0f };
 
-	float pauseTimer = 120.0f;
+	float pauseTimer = 2.0f;	// Seconds before input is accepted
 
 
 	struct Rigidbody
@@ -152,18 +206,18 @@ private:
 	{
 		void Draw() const
 		{
-			DrawTexture(tex, Collider(), 0);
+			DrawTexture(GetTexture(tex), Collider(), 0);	// Draws nothing until loaded
 		}
-		Texture* tex = LoadTexture("../Assets/img/TitleBack.jpg");
+		Handle tex;
 	}mPausebackground;
 
 	struct PauseText : public Entity
 	{
 		void Draw() const
 		{
-			DrawTexture(tex, Collider(), 0);
+			DrawTexture(GetTexture(tex), Collider(), 0);	// Draws nothing until loaded
 		}
-		Texture* tex = nullptr;
+		Handle tex;
 	}mPauseText;
 };
 
@@ -176,6 +230,8 @@ public:
 	void OnUpdate(float dt) final;
 	void OnRender() final;
 
+	bool IsReady() final;
+
 	TitleScene();
 	~TitleScene() final;
 
@@ -208,18 +264,18 @@ private:
 	{
 		void Draw() const
 		{
-			DrawTexture(tex, Collider(), 0);
+			DrawTexture(GetTexture(tex), Collider(), 0);	// Draws nothing until loaded
 		}
-		Texture* tex = LoadTexture("../Assets/img/TitleBack.jpg");
+		Handle tex;
 	}mTitlebackground;
 
 	struct TileText : public Entity
 	{
 		void Draw() const
 		{
-			DrawTexture(tex, Collider(), 0);
+			DrawTexture(GetTexture(tex), Collider(), 0);	// Draws nothing until loaded
 		}
-		Texture* tex = nullptr;
+		Handle tex;
 	}mTitleText;
 };
 
@@ -236,7 +292,7 @@ public:
 	void OnRender() final;
 
 private:
-	Texture* mShipTex = nullptr;
+	Sprite mShipSprite;
 	Texture* mAstTex = nullptr;
 	Rect mShipRec;
 	float mShipSpeed;
@@ -252,14 +308,14 @@ public:
 	void OnRender() final;
 
 private:
-	Texture* mTexEnterprise = nullptr;
-	Texture* mTexD7 = nullptr;
+	Sprite mEnterpriseSprite;
+	Sprite mD7Sprite;
 
 	struct Ship
 	{
 		Rect rec;
 		Point dir;
-		Texture* tex;
+		Sprite sprite;
 	};
 
 	std::array<Ship, 6> mShips;
@@ -322,12 +378,21 @@ private:
 	{
 		float damage = 10.0f;
 		Point direction;
-		Turret* parent = nullptr;
+		Handle parent;	// Turret that fired (may have been removed since)
 	};
 
-	std::vector<Turret> mTurrets;
-	std::vector<Enemy> mEnemies;
-	std::vector<Bullet> mBullets;
+	Pool<Turret> mTurrets;
+	Pool<Enemy> mEnemies;
+	Pool<Bullet> mBullets;
+
+	// Finds the nearest enemy for every turret in mFiring
+	void FindTargets();
+
+	SpatialGrid mEnemyGrid{ SCREEN, 64.0f };	// Enemy positions, rebuilt every update
+	std::vector<size_t> mFiring;			// Turrets firing this update
+	std::vector<int> mTargets;				// Nearest enemy to each firing turret (-1 if there are none)
+
+	friend void OnLab2Gui(void* data);
 };
 
 class AsteroidsScene : public Scene
@@ -342,11 +407,21 @@ public:
 	void OnUpdate(float dt) final;
 	void OnRender() final;
 
+	void OnPreload() final;
+	bool IsReady() final;
+	void OnResume() final;
+
 private:
-	Sound* sfxPlayerShoot = nullptr;
-	Sound* sfxShipHit = nullptr;
-	Music* bgmDefault = nullptr;
-	float pauseTimer = 120.0f;
+	std::future<bool> mPreload;		// Loads mPreloadedSave in the background
+	AsteroidsSave mPreloadedSave;
+
+	Sprite mBulletSprite;
+	Sprite mAsteroidSprite;
+	Handle sfxPlayerShoot;	// Loaded asynchronously so entering the scene doesn't hitch
+	Handle sfxShipHit;
+	Handle bgmDefault;
+	bool mMusicStarted = false;	// Music plays as soon as it finishes loading
+	float pauseTimer = 2.0f;	// Seconds before pausing is allowed
 
 	struct Timer
 	{
@@ -383,54 +458,159 @@ private:
 		}
 	};
 
-	struct Bullet : public Entity
+	enum SizeClass : Uint8
 	{
-		float damage = 100.0f;
-		void Draw() const
+		LARGE,
+		MEDIUM,
+		SMALL
+	};
+
+	// Bullets and asteroids are stored as structure-of-arrays so per-frame loops only stream through the fields they use.
+	// Removal swaps the last element into the removed slot, so order isn't preserved.
+	struct Bullets
+	{
+		std::vector<Point> positions;
+		std::vector<Point> previousPositions;	// Positions before the last tick (for render interpolation)
+		std::vector<Point> velocities;
+		size_t capacity = 0;
+		size_t highWater = 0;
+
+		size_t Count() const { return positions.size(); }
+		PoolUsage Usage() const { return { Count(), capacity, highWater }; }
+
+		// Preallocates so adding never reallocates (capacity only grows)
+		void Reserve(size_t count)
 		{
-			Color bulletColor = { 255, 0, 0, 255 };
-			//DrawRect(Collider(), bulletColor);
-			DrawTexture(tex, Collider(), Angle(direction) * RAD2DEG);
-			DrawLine(position, position + direction * 20.0f, bulletColor);
+			capacity = std::max(capacity, count);
+			positions.reserve(capacity);
+			previousPositions.reserve(capacity);
+			velocities.reserve(capacity);
 		}
-		Texture* tex = LoadTexture("../Assets/img/bolt.png");
-	};
 
-	// Add on to this class if necessary
-	struct Asteroid : public Entity
+		// Returns false if full
+		bool Add(Point position, Point velocity)
+		{
+			if (Count() >= capacity) return false;
+			positions.push_back(position);
+			previousPositions.push_back(position);
+			velocities.push_back(velocity);
+			highWater = std::max(highWater, Count());
+			return true;
+		}
+
+		void Remove(size_t i)
+		{
+			positions[i] = positions.back();
+			previousPositions[i] = previousPositions.back();
+			velocities[i] = velocities.back();
+			positions.pop_back();
+			previousPositions.pop_back();
+			velocities.pop_back();
+		}
+
+		void Clear()
+		{
+			positions.clear();
+			previousPositions.clear();
+			velocities.clear();
+		}
+	} mBullets;
+
+	struct Asteroids
 	{
-		float health = 100.0f;
-		float damage = 10.0f;
+		std::vector<Point> positions;
+		std::vector<Point> previousPositions;	// Positions before the last tick (for render interpolation)
+		std::vector<Point> velocities;
+		std::vector<float> halfExtents;	// Asteroids are square
+		std::vector<float> health;
+		std::vector<SizeClass> sizes;
+		size_t capacity = 0;
+		size_t highWater = 0;
+
+		size_t Count() const { return positions.size(); }
+		PoolUsage Usage() const { return { Count(), capacity, highWater }; }
+
+		// Preallocates so adding never reallocates (capacity only grows)
+		void Reserve(size_t count)
+		{
+			capacity = std::max(capacity, count);
+			positions.reserve(capacity);
+			previousPositions.reserve(capacity);
+			velocities.reserve(capacity);
+			halfExtents.reserve(capacity);
+			health.reserve(capacity);
+			sizes.reserve(capacity);
+		}
 
-		
-		void Draw() const
+		Rect Collider(size_t i) const
 		{
-			//DrawRect(Collider(), asteroidColor);
-			DrawTexture(tex, Collider());
-			DrawLine(position, position + direction * 20.0f, asteroidColor);
+			const float extent = halfExtents[i];
+			return { positions[i].x - extent, positions[i].y - extent, extent * 2.0f, extent * 2.0f };
 		}
-		Texture* tex = LoadTexture("../Assets/img/asteriod.png");
-		Color asteroidColor = { 255, 0, 255, 255 };
-	};
+
+		// Returns false if full
+		bool Add(Point position, Point velocity, float size, SizeClass sizeClass)
+		{
+			if (Count() >= capacity) return false;
+			positions.push_back(position);
+			previousPositions.push_back(position);
+			velocities.push_back(velocity);
+			halfExtents.push_back(size * 0.5f);
+			health.push_back(100.0f);
+			sizes.push_back(sizeClass);
+			highWater = std::max(highWater, Count());
+			return true;
+		}
+
+		void Remove(size_t i)
+		{
+			positions[i] = positions.back();
+			previousPositions[i] = previousPositions.back();
+			velocities[i] = velocities.back();
+			halfExtents[i] = halfExtents.back();
+			health[i] = health.back();
+			sizes[i] = sizes.back();
+			positions.pop_back();
+			previousPositions.pop_back();
+			velocities.pop_back();
+			halfExtents.pop_back();
+			health.pop_back();
+			sizes.pop_back();
+		}
+
+		void Clear()
+		{
+			positions.clear();
+			previousPositions.clear();
+			velocities.clear();
+			halfExtents.clear();
+			health.clear();
+			sizes.clear();
+		}
+	} mAsteroids;
 
 	struct Ship : public Entity
 	{
 		float speed;
 		float health = 100.0f;
-		float damageCooldown = 0.0f;
+		float damageCooldown = 0.0f;	// Cooldowns & delays are in seconds
 		float knockbackCooldown = 0.0f;
 		float collsionDelay = 0.0f;
 		float score = 0.0f;
 		float deathDelay = 0.0f;
+		Point previousPosition{};		// Position before the last tick (for render interpolation)
 
-		void Draw() const
+		// Draws the ship centred on at (interpolated position)
+		void Draw(Point at) const
 		{
-			//DrawRect(Collider(), col);
-			DrawTexture(tex, mShipRec, Angle(direction) * RAD2DEG);
-			DrawLine(position, position + direction * 100.0f, col3);
+			Rect rec{ at.x - width * 0.5f, at.y - height * 0.5f, width, height };
+			//DrawRect(rec, col);
+			DrawSprite(sprite, rec, Angle(direction) * RAD2DEG, tint);
+			DrawLine(at, at + direction * 100.0f, col3);
 		}
 		Rect mShipRec;
-		Texture* tex = nullptr;
+		Sprite sprite;
+		Color tint{ 255, 255, 255, 255 };	// Atlas is shared, so tint per-draw rather than per-texture
 		Timer bulletCooldown;
 		Color col3{ 255, 179, 179, 255 };
 		Color col2{ 255, 102, 102, 255 };
@@ -441,9 +621,12 @@ private:
 	{
 		void Draw() const
 		{
-			DrawTexture(texBackground, Collider(),0);
+			// Nothing to draw until the background has loaded
+			Texture* texture = GetTexture(texBackground);
+			if (texture != nullptr)
+				DrawTexture(texture, Collider(), 0);
 		}
-		Texture* texBackground = nullptr;
+		Handle texBackground;
 	} mBackground;
 	Color mTestColor{ 255, 255, 255, 255 };
 
@@ -451,18 +634,28 @@ private:
 	// Container of small asteroids
 	// Container of medium asteroids
 	// Timer to spawn asteroids
-	std::vector<Bullet> mBullets;
 	Timer mAsteroidTimer;
 
-	std::vector<Asteroid> mAsteroidsLarge;
-	std::vector<Asteroid> mAsteroidsMedium;
-	std::vector<Asteroid> mAsteroidsSmall;
 	const float mSizeLarge = 75.0f;
 	const float mSizeMedium = 50.0f;
 	const float mSizeSmall = 25.0f;
+	const float mBulletSize = 50.0f;
+	const float mBulletDamage = 100.0f;
+	const float mAsteroidDamage = 10.0f;
+	const Color mBulletColor = { 255, 0, 0, 255 };
+	const Color mAsteroidColor = { 255, 0, 255, 255 };
+
+	// Broadphase over all asteroids (ids are indices into mAsteroids), rebuilt before collision tests each frame
+	SpatialGrid mGrid{ SCREEN, 128.0f };
 
 	friend void OnAsteroidsGui(void* data);
 
-	Asteroid SpawnAsteroid(float size);
+	void SpawnAsteroid(float size);
 	void Wrap(Entity& entity);
+
+	void BuildGrid();
+	Rect BulletCollider(size_t i) const;
+
+	// Position between previous and current ticks, snapping instead of sliding across the screen when wrapped
+	static Point Interpolate(Point previous, Point current, float alpha);
 };
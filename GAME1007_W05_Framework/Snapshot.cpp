@@ -0,0 +1,214 @@
+#include "Snapshot.h"
+#include <array>
+#include <cstring>
+
+using namespace std;
+
+constexpr Uint32 SNAPSHOT_MAGIC = FourCC('S', 'N', 'A', 'P');
+
+// CRC-32 (IEEE, as used by zip & png)
+static Uint32 Crc32(const Uint8* data, size_t size)
+{
+	static const array<Uint32, 256> table = []
+	{
+		array<Uint32, 256> result{};
+		for (Uint32 i = 0; i < 256; i++)
+		{
+			Uint32 crc = i;
+			for (int bit = 0; bit < 8; bit++)
+				crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+			result[i] = crc;
+		}
+		return result;
+	}();
+
+	Uint32 crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFFu;
+}
+
+static void PutU32(Uint8* out, Uint32 value)
+{
+	out[0] = (Uint8)value;
+	out[1] = (Uint8)(value >> 8);
+	out[2] = (Uint8)(value >> 16);
+	out[3] = (Uint8)(value >> 24);
+}
+
+static Uint32 GetU32(const Uint8* in)
+{
+	return (Uint32)in[0] | (Uint32)in[1] << 8 | (Uint32)in[2] << 16 | (Uint32)in[3] << 24;
+}
+
+void SnapshotWriter::Begin(Uint32 kind, Uint16 version, size_t payloadSize)
+{
+	mBuffer.clear();
+	mBuffer.reserve(SNAPSHOT_HEADER_SIZE + payloadSize);
+	Write(SNAPSHOT_MAGIC);
+	Write(kind);
+	Write(version);
+	Write((Uint16)0);
+	Write((Uint32)0);	// Size & checksum are filled in by End
+	Write((Uint32)0);
+}
+
+void SnapshotWriter::Write(Uint8 value)
+{
+	mBuffer.push_back(value);
+}
+
+void SnapshotWriter::Write(Uint16 value)
+{
+	mBuffer.push_back((Uint8)value);
+	mBuffer.push_back((Uint8)(value >> 8));
+}
+
+void SnapshotWriter::Write(Uint32 value)
+{
+	const size_t offset = mBuffer.size();
+	mBuffer.resize(offset + 4);
+	PutU32(&mBuffer[offset], value);
+}
+
+void SnapshotWriter::Write(Sint32 value)
+{
+	Write((Uint32)value);
+}
+
+void SnapshotWriter::Write(float value)
+{
+	Uint32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	Write(bits);
+}
+
+void SnapshotWriter::Write(Point value)
+{
+	Write(value.x);
+	Write(value.y);
+}
+
+void SnapshotWriter::Write(Rect value)
+{
+	Write(value.x);
+	Write(value.y);
+	Write(value.w);
+	Write(value.h);
+}
+
+void SnapshotWriter::End()
+{
+	const size_t size = mBuffer.size() - SNAPSHOT_HEADER_SIZE;
+	PutU32(&mBuffer[12], (Uint32)size);
+	PutU32(&mBuffer[16], Crc32(mBuffer.data() + SNAPSHOT_HEADER_SIZE, size));
+}
+
+bool SnapshotWriter::Save(const char* path) const
+{
+	SDL_RWops* file = SDL_RWFromFile(path, "wb");
+	if (file == nullptr) return false;
+
+	const bool written = SDL_RWwrite(file, mBuffer.data(), 1, mBuffer.size()) == mBuffer.size();
+	return SDL_RWclose(file) == 0 && written;
+}
+
+bool SnapshotReader::Load(const char* path, Uint32 kind, Uint16 version)
+{
+	mBuffer.clear();
+	mPosition = 0;
+	mFailed = true;
+
+	SDL_RWops* file = SDL_RWFromFile(path, "rb");
+	if (file == nullptr) return false;
+
+	const Sint64 size = SDL_RWsize(file);
+	if (size >= (Sint64)SNAPSHOT_HEADER_SIZE)
+	{
+		mBuffer.resize((size_t)size);
+		if (SDL_RWread(file, mBuffer.data(), 1, mBuffer.size()) != mBuffer.size())
+			mBuffer.clear();
+	}
+	SDL_RWclose(file);
+	if (mBuffer.size() < SNAPSHOT_HEADER_SIZE) return false;
+
+	const Uint8* header = mBuffer.data();
+	const Uint32 payloadSize = GetU32(header + 12);
+	if (GetU32(header) != SNAPSHOT_MAGIC || GetU32(header + 4) != kind) return false;
+	if ((Uint16)(header[8] | header[9] << 8) != version) return false;
+	if (payloadSize != mBuffer.size() - SNAPSHOT_HEADER_SIZE) return false;
+	if (GetU32(header + 16) != Crc32(header + SNAPSHOT_HEADER_SIZE, payloadSize)) return false;
+
+	mPosition = SNAPSHOT_HEADER_SIZE;
+	mFailed = false;
+	return true;
+}
+
+const Uint8* SnapshotReader::Take(size_t count)
+{
+	if (mFailed || mBuffer.size() - mPosition < count)
+	{
+		mFailed = true;
+		return nullptr;
+	}
+
+	const Uint8* data = mBuffer.data() + mPosition;
+	mPosition += count;
+	return data;
+}
+
+bool SnapshotReader::Read(Uint8& value)
+{
+	const Uint8* data = Take(1);
+	if (data == nullptr) return false;
+	value = data[0];
+	return true;
+}
+
+bool SnapshotReader::Read(Uint16& value)
+{
+	const Uint8* data = Take(2);
+	if (data == nullptr) return false;
+	value = (Uint16)(data[0] | data[1] << 8);
+	return true;
+}
+
+bool SnapshotReader::Read(Uint32& value)
+{
+	const Uint8* data = Take(4);
+	if (data == nullptr) return false;
+	value = GetU32(data);
+	return true;
+}
+
+bool SnapshotReader::Read(Sint32& value)
+{
+	Uint32 bits;
+	if (!Read(bits)) return false;
+	value = (Sint32)bits;
+	return true;
+}
+
+bool SnapshotReader::Read(float& value)
+{
+	Uint32 bits;
+	if (!Read(bits)) return false;
+	memcpy(&value, &bits, sizeof(value));
+	return true;
+}
+
+bool SnapshotReader::Read(Point& value)
+{
+	Point result;
+	if (!Read(result.x) || !Read(result.y)) return false;
+	value = result;
+	return true;
+}
+
+bool SnapshotReader::Read(Rect& value)
+{
+	Rect result;
+	if (!Read(result.x) || !Read(result.y) || !Read(result.w) || !Read(result.h)) return false;
+	value = result;
+	return true;
+}
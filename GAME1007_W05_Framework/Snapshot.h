@@ -0,0 +1,67 @@
+#pragma once
+#include "Math.h"
+#include <vector>
+
+// Versioned binary save format. Every file is a 20-byte header followed by the payload, all little-endian:
+//	magic "SNAP" | kind (FourCC of what's stored) | version (u16) | reserved (u16) | payload size (u32) | CRC-32 of payload (u32)
+// Readers reject files whose magic, kind, version or checksum don't match, so a truncated, hand-edited or outdated file
+// falls back to the XML.
+
+constexpr Uint32 FourCC(char a, char b, char c, char d)
+{
+	return (Uint32)(Uint8)a | (Uint32)(Uint8)b << 8 | (Uint32)(Uint8)c << 16 | (Uint32)(Uint8)d << 24;
+}
+
+constexpr size_t SNAPSHOT_HEADER_SIZE = 20;
+
+class SnapshotWriter
+{
+public:
+	// Starts a new snapshot. Reserve the payload size up-front (if known) so writing never reallocates.
+	void Begin(Uint32 kind, Uint16 version, size_t payloadSize = 0);
+
+	void Write(Uint8 value);
+	void Write(Uint16 value);
+	void Write(Uint32 value);
+	void Write(Sint32 value);
+	void Write(float value);
+	void Write(Point value);
+	void Write(Rect value);
+
+	// Fills in the header's size & checksum. Call once everything has been written.
+	void End();
+
+	// Writes the finished snapshot with a single write. Returns false on failure.
+	bool Save(const char* path) const;
+
+	const std::vector<Uint8>& Data() const { return mBuffer; }
+
+private:
+	std::vector<Uint8> mBuffer;
+};
+
+class SnapshotReader
+{
+public:
+	// Reads the whole file at once and validates its header & checksum.
+	// Returns false if it's missing, corrupt, not kind or written with a different version (a different payload layout).
+	bool Load(const char* path, Uint32 kind, Uint16 version);
+
+	// Reads fail (leaving value unchanged) once the payload is exhausted, and Ok() then returns false
+	bool Read(Uint8& value);
+	bool Read(Uint16& value);
+	bool Read(Uint32& value);
+	bool Read(Sint32& value);
+	bool Read(float& value);
+	bool Read(Point& value);
+	bool Read(Rect& value);
+
+	bool Ok() const { return !mFailed; }
+
+private:
+	const Uint8* Take(size_t count);
+
+	std::vector<Uint8> mBuffer;
+	size_t mPosition = 0;
+	bool mFailed = false;
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include "Math.h"
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+
+// Uniform grid broadphase over a fixed area. Objects are referred to by dense ids (0 to n - 1).
+// Rects that extend past the bounds are clamped into the edge cells, so objects that have been
+// wrapped to the opposite side of the screen (or hang off its edge) still land in valid cells.
+class SpatialGrid
+{
+public:
+	SpatialGrid(const Rect& bounds, float cellSize)
+		: mBounds(bounds), mCellSize(cellSize)
+	{
+		mColumns = (int)ceilf(bounds.w / cellSize);
+		mRows = (int)ceilf(bounds.h / cellSize);
+		mCells.resize(mColumns * mRows);
+	}
+
+	// Empties every cell (keeps their memory so rebuilding each frame doesn't allocate)
+	void Clear()
+	{
+		for (std::vector<int>& cell : mCells)
+			cell.clear();
+	}
+
+	// Adds id to every cell rect overlaps
+	void Insert(int id, const Rect& rect)
+	{
+		if (id >= (int)mStamps.size())
+			mStamps.resize(id + 1, 0);
+
+		int x0, y0, x1, y1;
+		CellRange(rect, x0, y0, x1, y1);
+		for (int y = y0; y <= y1; y++)
+		{
+			for (int x = x0; x <= x1; x++)
+				mCells[y * mColumns + x].push_back(id);
+		}
+	}
+
+	// Calls callback(id) once for every object sharing a cell with rect
+	template<typename Callback>
+	void Query(const Rect& rect, Callback callback)
+	{
+		// Stamp ids as they're visited so objects spanning several cells are only reported once
+		if (++mStamp == 0)
+		{
+			std::fill(mStamps.begin(), mStamps.end(), 0);
+			mStamp = 1;
+		}
+
+		int x0, y0, x1, y1;
+		CellRange(rect, x0, y0, x1, y1);
+		for (int y = y0; y <= y1; y++)
+		{
+			for (int x = x0; x <= x1; x++)
+			{
+				for (int id : mCells[y * mColumns + x])
+				{
+					if (mStamps[id] == mStamp) continue;
+					mStamps[id] = mStamp;
+					callback(id);
+				}
+			}
+		}
+	}
+
+	// Returns the id with the smallest distanceSqr(id) to point, or -1 if the grid is empty.
+	// Searches rings of cells outwards from point and stops once no unvisited cell can hold anything closer, so
+	// distanceSqr must measure to a point inside the rect each object was inserted with (ie objects inserted as points).
+	// Doesn't touch the query stamps, so it's safe to call from several threads at once.
+	template<typename DistanceSqr>
+	int Nearest(Point point, DistanceSqr distanceSqr) const
+	{
+		const int cx = Cell(point.x - mBounds.x, mColumns);
+		const int cy = Cell(point.y - mBounds.y, mRows);
+		const int rings = std::max(std::max(cx, mColumns - 1 - cx), std::max(cy, mRows - 1 - cy));
+
+		int nearest = -1;
+		float nearestDistance = FLT_MAX;
+		for (int ring = 0; ring <= rings; ring++)
+		{
+			// Everything in this ring or beyond lies outside the block of cells already searched
+			if (nearest >= 0 && ring > 0)
+			{
+				const float bound = RingDistance(point, cx, cy, ring - 1);
+				if (nearestDistance <= bound * bound) break;
+			}
+
+			for (int y = cy - ring; y <= cy + ring; y++)
+			{
+				if (y < 0 || y >= mRows) continue;
+
+				// Only the edges of the ring are new, so step across its interior rows
+				const bool edge = y == cy - ring || y == cy + ring;
+				const int step = edge ? 1 : ring * 2;
+				for (int x = cx - ring; x <= cx + ring; x += step)
+				{
+					if (x < 0 || x >= mColumns) continue;
+					for (int id : mCells[y * mColumns + x])
+					{
+						const float distance = distanceSqr(id);
+						if (distance < nearestDistance)
+						{
+							nearestDistance = distance;
+							nearest = id;
+						}
+					}
+				}
+			}
+		}
+		return nearest;
+	}
+
+private:
+	// Distance from point to the nearest edge of the block of cells within ring of (cx, cy).
+	// Edges on the border of the grid don't count since nothing lies beyond them.
+	float RingDistance(Point point, int cx, int cy, int ring) const
+	{
+		float distance = FLT_MAX;
+		if (cx - ring > 0) distance = std::min(distance, point.x - (mBounds.x + (cx - ring) * mCellSize));
+		if (cx + ring < mColumns - 1) distance = std::min(distance, mBounds.x + (cx + ring + 1) * mCellSize - point.x);
+		if (cy - ring > 0) distance = std::min(distance, point.y - (mBounds.y + (cy - ring) * mCellSize));
+		if (cy + ring < mRows - 1) distance = std::min(distance, mBounds.y + (cy + ring + 1) * mCellSize - point.y);
+		return std::max(distance, 0.0f);
+	}
+
+	void CellRange(const Rect& rect, int& x0, int& y0, int& x1, int& y1) const
+	{
+		x0 = Cell(rect.x - mBounds.x, mColumns);
+		y0 = Cell(rect.y - mBounds.y, mRows);
+		x1 = Cell(rect.x + rect.w - mBounds.x, mColumns);
+		y1 = Cell(rect.y + rect.h - mBounds.y, mRows);
+	}
+
+	int Cell(float offset, int count) const
+	{
+		return (int)Clamp(floorf(offset / mCellSize), 0.0f, (float)(count - 1));
+	}
+
+	Rect mBounds;
+	float mCellSize;
+	int mColumns;
+	int mRows;
+
+	std::vector<std::vector<int>> mCells;	// Ids of the objects overlapping each cell (row-major)
+	std::vector<unsigned int> mStamps;		// Query each id was last reported by
+	unsigned int mStamp = 0;				// Current query
+};
@@ -0,0 +1,112 @@
+#include "XmlBatch.h"
+#include "CachedDocument.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace tinyxml2;
+
+static void LoadXmlFile(const string& path, size_t index, const XmlBatchReader& read, XmlFileStatus& status)
+{
+	CachedDocument doc;
+	if (doc->LoadFile(path.c_str()) != XML_SUCCESS)
+	{
+		status.error = doc->ErrorID();
+		status.line = doc->ErrorLineNum();
+		status.message = doc->ErrorStr();
+	}
+	else if (!read(index, *doc))
+	{
+		status.error = XML_ERROR_PARSING;
+		status.message = "Couldn't read " + path;
+	}
+}
+
+// Workers persist between batches so their cached documents stay warm and batches don't pay for starting threads
+struct XmlBatchPool
+{
+	vector<thread> workers;		// Grown to the most threads any batch has asked for
+	mutex batching;				// Held for a whole batch so concurrent callers take turns
+	mutex lock;					// Guards everything below
+	condition_variable wake;	// Signals workers when there's a batch to join or they should stop
+	condition_variable idle;	// Signals the caller whenever a worker finishes its part of the batch
+	function<void()> work;		// Current batch (shared by every worker that joins it)
+	size_t wanted = 0;			// Workers still to join the current batch
+	size_t busy = 0;			// Workers running the current batch
+	bool stopping = false;
+} gXmlBatch;
+
+static void XmlBatchWorker()
+{
+	unique_lock<mutex> lock(gXmlBatch.lock);
+	while (true)
+	{
+		gXmlBatch.wake.wait(lock, [] { return gXmlBatch.stopping || gXmlBatch.wanted > 0; });
+		if (gXmlBatch.stopping) return;
+
+		gXmlBatch.wanted--;
+		gXmlBatch.busy++;
+		lock.unlock();
+		gXmlBatch.work();
+		lock.lock();
+		gXmlBatch.busy--;
+		gXmlBatch.idle.notify_all();
+	}
+}
+
+vector<XmlFileStatus> LoadXmlBatch(const vector<string>& paths, const XmlBatchReader& read, size_t threads)
+{
+	vector<XmlFileStatus> statuses(paths.size());
+	if (threads == 0)
+		threads = max(thread::hardware_concurrency(), 1u);
+	threads = min(threads, paths.size());
+
+	// Files vary in size, so workers take the next file as they finish rather than a fixed share
+	atomic<size_t> next{ 0 };
+	auto work = [&]
+	{
+		for (size_t i = next++; i < paths.size(); i = next++)
+			LoadXmlFile(paths[i], i, read, statuses[i]);
+	};
+
+	if (threads <= 1)
+	{
+		work();
+		return statuses;
+	}
+
+	lock_guard<mutex> batch(gXmlBatch.batching);
+	{
+		lock_guard<mutex> lock(gXmlBatch.lock);
+		gXmlBatch.stopping = false;
+		while (gXmlBatch.workers.size() < threads - 1)
+			gXmlBatch.workers.emplace_back(XmlBatchWorker);
+		gXmlBatch.work = work;
+		gXmlBatch.wanted = threads - 1;
+	}
+	gXmlBatch.wake.notify_all();
+	work();
+
+	// Every file has been taken, so workers that haven't joined yet have nothing left to do
+	unique_lock<mutex> lock(gXmlBatch.lock);
+	gXmlBatch.wanted = 0;
+	gXmlBatch.idle.wait(lock, [] { return gXmlBatch.busy == 0; });
+	gXmlBatch.work = nullptr;
+	return statuses;
+}
+
+void StopXmlBatches()
+{
+	{
+		lock_guard<mutex> lock(gXmlBatch.lock);
+		if (gXmlBatch.workers.empty()) return;
+		gXmlBatch.stopping = true;
+	}
+	gXmlBatch.wake.notify_all();
+	for (thread& worker : gXmlBatch.workers)
+		worker.join();
+	gXmlBatch.workers.clear();
+}
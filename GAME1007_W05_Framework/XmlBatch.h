@@ -0,0 +1,26 @@
+#pragma once
+#include "tinyxml2.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Loads many XML files at once (ie per-entity definition files) by parsing them concurrently.
+// Each worker thread parses into its own cached document (see CachedDocument.h) and hands it to read, which should
+// copy out whatever it needs since the document is reused for the worker's next file (and later batches).
+// read runs on the worker threads, so it must only write to state for its own index (ie results[index]).
+
+using XmlBatchReader = std::function<bool(size_t index, const tinyxml2::XMLDocument& doc)>;
+
+struct XmlFileStatus
+{
+	tinyxml2::XMLError error = tinyxml2::XML_SUCCESS;	// XML_ERROR_PARSING if read returned false
+	int line = 0;
+	std::string message;
+
+	bool Ok() const { return error == tinyxml2::XML_SUCCESS; }
+};
+
+// Returns the status of each path in the same order. threads = 0 uses one per core (the caller counts as one).
+// Worker threads are started by the first batch that needs them and kept for later batches. Don't call from read.
+std::vector<XmlFileStatus> LoadXmlBatch(const std::vector<std::string>& paths, const XmlBatchReader& read, size_t threads = 0);
+void StopXmlBatches();	// Stops the worker threads (called by AppExit)
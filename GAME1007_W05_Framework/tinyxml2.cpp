@@ -122,6 +122,28 @@ distribution.
 	#define TIXML_FTELL ftell
 #endif
 
+// std::from_chars/to_chars (C++17) convert numbers without the locale lookups & format parsing of sscanf/snprintf.
+// Floating point support arrived later than integer support, so key off the library feature macro.
+// Define TIXML_NO_CHARCONV to always use the stdio conversions.
+#if !defined(TIXML_NO_CHARCONV) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+	#include <charconv>
+	#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+		#define TIXML_CHARCONV
+	#endif
+#endif
+
+// Large files are mapped copy-on-write rather than read into a new[] buffer. The parser still writes into
+// the buffer in place, but pages are read lazily and only the ones it changes get copied.
+// Define TIXML_NO_MMAP to always read files.
+#if !defined(TIXML_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#define TIXML_MMAP
+	#ifndef TIXML_MMAP_THRESHOLD
+		#define TIXML_MMAP_THRESHOLD (64 * 1024)	// Smaller files are cheaper to read than to map
+	#endif
+#endif
+
 
 static const char LINE_FEED				= static_cast<char>(0x0a);			// all line endings are normalized to LF
 static const char LF = LINE_FEED;
@@ -571,14 +593,60 @@ const char* XMLUtil::GetCharacterRef( const char* p, char* value, int* length )
 }
 
 
+#ifdef TIXML_CHARCONV
+// Writes the shortest text that reads back as v. Returns false if it doesn't fit.
+template<typename T>
+static bool ToChars( T v, char* buffer, int bufferSize )
+{
+    if ( bufferSize <= 0 ) {
+        return false;
+    }
+    const std::to_chars_result result = std::to_chars( buffer, buffer + bufferSize - 1, v );
+    if ( result.ec != std::errc() ) {
+        return false;
+    }
+    *result.ptr = 0;
+    return true;
+}
+
+// Accepts what sscanf would for decimal input (leading whitespace & '+' included). Anything else, such as
+// hex or out of range values, returns false so the caller falls back to sscanf & keeps its behavior.
+template<typename T>
+static bool FromChars( const char* str, T* value )
+{
+    const char* p = XMLUtil::SkipWhiteSpace( str, 0 );
+    if ( *p == '+' && p[1] != '-' ) {
+        ++p;
+    }
+    T result;
+    const std::from_chars_result parsed = std::from_chars( p, p + strlen( p ), result );
+    if ( parsed.ec != std::errc() ) {
+        return false;
+    }
+    *value = result;
+    return true;
+}
+#endif
+
+
 void XMLUtil::ToStr( int v, char* buffer, int bufferSize )
 {
+#ifdef TIXML_CHARCONV
+    if ( ToChars( v, buffer, bufferSize ) ) {
+        return;
+    }
+#endif
     TIXML_SNPRINTF( buffer, bufferSize, "%d", v );
 }
 
 
 void XMLUtil::ToStr( unsigned v, char* buffer, int bufferSize )
 {
+#ifdef TIXML_CHARCONV
+    if ( ToChars( v, buffer, bufferSize ) ) {
+        return;
+    }
+#endif
     TIXML_SNPRINTF( buffer, bufferSize, "%u", v );
 }
 
@@ -591,27 +659,49 @@ void XMLUtil::ToStr( bool v, char* buffer, int bufferSize )
 /*
 	ToStr() of a number is a very tricky topic.
 	https://github.com/leethomason/tinyxml2/issues/106
+	With charconv, floats & doubles are written as the shortest text that reads back exactly,
+	so 0.1f is "0.1" rather than however many digits a fixed precision gives.
 */
 void XMLUtil::ToStr( float v, char* buffer, int bufferSize )
 {
+#ifdef TIXML_CHARCONV
+    if ( ToChars( v, buffer, bufferSize ) ) {
+        return;
+    }
+#endif
     TIXML_SNPRINTF( buffer, bufferSize, "%.8g", v );
 }
 
 
 void XMLUtil::ToStr( double v, char* buffer, int bufferSize )
 {
+#ifdef TIXML_CHARCONV
+    if ( ToChars( v, buffer, bufferSize ) ) {
+        return;
+    }
+#endif
     TIXML_SNPRINTF( buffer, bufferSize, "%.17g", v );
 }
 
 
 void XMLUtil::ToStr( int64_t v, char* buffer, int bufferSize )
 {
+#ifdef TIXML_CHARCONV
+    if ( ToChars( v, buffer, bufferSize ) ) {
+        return;
+    }
+#endif
 	// horrible syntax trick to make the compiler happy about %lld
 	TIXML_SNPRINTF(buffer, bufferSize, "%lld", static_cast<long long>(v));
 }
 
 void XMLUtil::ToStr( uint64_t v, char* buffer, int bufferSize )
 {
+#ifdef TIXML_CHARCONV
+    if ( ToChars( v, buffer, bufferSize ) ) {
+        return;
+    }
+#endif
     // horrible syntax trick to make the compiler happy about %llu
     TIXML_SNPRINTF(buffer, bufferSize, "%llu", (long long)v);
 }
@@ -626,6 +716,11 @@ bool XMLUtil::ToInt(const char* str, int* value)
         }
     }
     else {
+#ifdef TIXML_CHARCONV
+        if (FromChars(str, value)) {
+            return true;
+        }
+#endif
         if (TIXML_SSCANF(str, "%d", value) == 1) {
             return true;
         }
@@ -635,6 +730,11 @@ bool XMLUtil::ToInt(const char* str, int* value)
 
 bool XMLUtil::ToUnsigned(const char* str, unsigned* value)
 {
+#ifdef TIXML_CHARCONV
+    if (!IsPrefixHex(str) && FromChars(str, value)) {
+        return true;
+    }
+#endif
     if (TIXML_SSCANF(str, IsPrefixHex(str) ? "%x" : "%u", value) == 1) {
         return true;
     }
@@ -669,6 +769,12 @@ bool XMLUtil::ToBool( const char* str, bool* value )
 
 bool XMLUtil::ToFloat( const char* str, float* value )
 {
+#ifdef TIXML_CHARCONV
+    // sscanf reads hex floats, whereas from_chars would stop at the 'x'
+    if ( !IsPrefixHex( str ) && FromChars( str, value ) ) {
+        return true;
+    }
+#endif
     if ( TIXML_SSCANF( str, "%f", value ) == 1 ) {
         return true;
     }
@@ -678,6 +784,11 @@ bool XMLUtil::ToFloat( const char* str, float* value )
 
 bool XMLUtil::ToDouble( const char* str, double* value )
 {
+#ifdef TIXML_CHARCONV
+    if ( !IsPrefixHex( str ) && FromChars( str, value ) ) {
+        return true;
+    }
+#endif
     if ( TIXML_SSCANF( str, "%lf", value ) == 1 ) {
         return true;
     }
@@ -695,6 +806,11 @@ bool XMLUtil::ToInt64(const char* str, int64_t* value)
         }
     }
     else {
+#ifdef TIXML_CHARCONV
+        if (FromChars(str, value)) {
+            return true;
+        }
+#endif
         long long v = 0;	// horrible syntax trick to make the compiler happy about %lld
         if (TIXML_SSCANF(str, "%lld", &v) == 1) {
             *value = static_cast<int64_t>(v);
@@ -706,6 +822,11 @@ bool XMLUtil::ToInt64(const char* str, int64_t* value)
 
 
 bool XMLUtil::ToUnsigned64(const char* str, uint64_t* value) {
+#ifdef TIXML_CHARCONV
+    if (!IsPrefixHex(str) && FromChars(str, value)) {
+        return true;
+    }
+#endif
     unsigned long long v = 0;	// horrible syntax trick to make the compiler happy about %llu
     if(TIXML_SSCANF(str, IsPrefixHex(str) ? "%llx" : "%llu", &v) == 1) {
         *value = (uint64_t)v;
@@ -2165,6 +2286,10 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
     _errorStr(),
     _errorLineNum( 0 ),
     _charBuffer( 0 ),
+    _charBufferMapped( 0 ),
+    _charBufferSize( 0 ),
+    _spareBuffer( 0 ),
+    _spareBufferSize( 0 ),
     _parseCurLineNum( 0 ),
 	_parsingDepth(0),
     _unlinked(),
@@ -2180,7 +2305,7 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
 
 XMLDocument::~XMLDocument()
 {
-    Clear();
+    ReleaseMemory();
 }
 
 
@@ -2209,8 +2334,26 @@ void XMLDocument::Clear()
 #endif
     ClearError();
 
-    delete [] _charBuffer;
-    _charBuffer = 0;
+#ifdef TIXML_MMAP
+    if ( _charBufferMapped ) {
+        munmap( _charBuffer, _charBufferMapped );
+        _charBuffer = 0;
+        _charBufferMapped = 0;
+    }
+#endif
+    if ( _charBuffer ) {
+        // Keep the larger of the two buffers for the next parse
+        if ( _charBufferSize > _spareBufferSize ) {
+            delete [] _spareBuffer;
+            _spareBuffer = _charBuffer;
+            _spareBufferSize = _charBufferSize;
+        }
+        else {
+            delete [] _charBuffer;
+        }
+        _charBuffer = 0;
+        _charBufferSize = 0;
+    }
 	_parsingDepth = 0;
 
 #if 0
@@ -2376,7 +2519,13 @@ XMLError XMLDocument::LoadFile( FILE* fp )
 
     const size_t size = static_cast<size_t>(filelength);
     TIXMLASSERT( _charBuffer == 0 );
-    _charBuffer = new char[size+1];
+#ifdef TIXML_MMAP
+    if ( size >= TIXML_MMAP_THRESHOLD && MapFile( fp, size ) ) {
+        Parse();
+        return _errorID;
+    }
+#endif
+    _charBuffer = AllocCharBuffer( size+1 );
     const size_t read = fread( _charBuffer, 1, size, fp );
     if ( read != size ) {
         SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
@@ -2432,7 +2581,7 @@ XMLError XMLDocument::Parse( const char* xml, size_t nBytes )
         nBytes = strlen( xml );
     }
     TIXMLASSERT( _charBuffer == 0 );
-    _charBuffer = new char[ nBytes+1 ];
+    _charBuffer = AllocCharBuffer( nBytes+1 );
     memcpy( _charBuffer, xml, nBytes );
     _charBuffer[nBytes] = 0;
 
@@ -2538,6 +2687,69 @@ void XMLDocument::Parse()
     ParseDeep(p, 0, &_parseCurLineNum );
 }
 
+void XMLDocument::Reserve( int elements, int attributes, int texts, int comments )
+{
+    _elementPool.Reserve( elements );
+    _attributePool.Reserve( attributes );
+    _textPool.Reserve( texts );
+    _commentPool.Reserve( comments );
+}
+
+
+void XMLDocument::ReleaseMemory()
+{
+    Clear();
+    delete [] _spareBuffer;
+    _spareBuffer = 0;
+    _spareBufferSize = 0;
+    _elementPool.Clear();
+    _attributePool.Clear();
+    _textPool.Clear();
+    _commentPool.Clear();
+}
+
+
+// Returns the spare buffer from an earlier parse if it's big enough, otherwise a new one
+char* XMLDocument::AllocCharBuffer( size_t size )
+{
+    TIXMLASSERT( _charBuffer == 0 );
+    if ( _spareBufferSize >= size ) {
+        char* buffer = _spareBuffer;
+        _charBufferSize = _spareBufferSize;
+        _spareBuffer = 0;
+        _spareBufferSize = 0;
+        return buffer;
+    }
+    _charBufferSize = size;
+    return new char[size];
+}
+
+
+#ifdef TIXML_MMAP
+// Maps the file as a private, writable buffer for Parse(). The mapping is a page longer than the file, and
+// whatever follows the file within its mapped pages reads as zero, so the buffer is always null terminated.
+// Files replaced by renaming over them (as safe savers do) don't disturb an existing mapping, but a file
+// truncated while it's mapped will fault.
+bool XMLDocument::MapFile( FILE* fp, size_t size )
+{
+    const size_t page = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+    const size_t length = ( size / page + 1 ) * page;
+    void* buffer = mmap( 0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( buffer == MAP_FAILED ) {
+        return false;
+    }
+    if ( mmap( buffer, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fileno( fp ), 0 ) == MAP_FAILED ) {
+        munmap( buffer, length );
+        return false;
+    }
+    madvise( buffer, size, MADV_SEQUENTIAL );	// The parser reads front to back
+
+    _charBuffer = static_cast<char*>( buffer );
+    _charBufferMapped = length;
+    return true;
+}
+#endif
+
 void XMLDocument::PushDepth()
 {
 	_parsingDepth++;
@@ -2552,6 +2764,527 @@ void XMLDocument::PopDepth()
 	--_parsingDepth;
 }
 
+// --------- XMLStreamReader ----------- //
+
+XMLStreamReader::XMLStreamReader( bool processEntities ) :
+    _processEntities( processEntities ),
+    _fp( 0 ),
+    _ownsFile( false ),
+    _buffer( 0 ),
+    _capacity( 0 )
+{
+    Reset();
+    _eof = true;
+}
+
+
+XMLStreamReader::~XMLStreamReader()
+{
+    Close();
+    delete [] _buffer;
+}
+
+
+void XMLStreamReader::Reset()
+{
+    _source = 0;
+    _sourceRemaining = 0;
+    _eof = false;
+    _size = 0;
+    _pos = 0;
+    _lineNum = 1;
+    if ( _buffer ) {
+        _buffer[0] = 0;
+    }
+
+    _event = START_ELEMENT;
+    _eventLineNum = 0;
+    _started = false;
+    _sawElement = false;
+    _endPending = false;
+    _popPending = false;
+    _restoreChar = 0;
+    _text = 0;
+    _attributes.Clear();
+    _names.Clear();
+    _nameStarts.Clear();
+
+    _errorID = XML_SUCCESS;
+    _errorLineNum = 0;
+}
+
+
+XMLError XMLStreamReader::Open( const char* filename )
+{
+    TIXMLASSERT( filename );
+    FILE* fp = callfopen( filename, "rb" );
+    if ( !fp ) {
+        Close();
+        SetError( XML_ERROR_FILE_NOT_FOUND, 0 );
+        return _errorID;
+    }
+    Open( fp );
+    _ownsFile = true;
+    return XML_SUCCESS;
+}
+
+
+void XMLStreamReader::Open( FILE* fp )
+{
+    TIXMLASSERT( fp );
+    Close();
+    Reset();
+    _fp = fp;
+}
+
+
+void XMLStreamReader::Parse( const char* xml, size_t nBytes )
+{
+    TIXMLASSERT( xml );
+    Close();
+    Reset();
+    _source = xml;
+    _sourceRemaining = nBytes == static_cast<size_t>(-1) ? strlen( xml ) : nBytes;
+}
+
+
+void XMLStreamReader::Close()
+{
+    if ( _ownsFile && _fp ) {
+        fclose( _fp );
+    }
+    _fp = 0;
+    _ownsFile = false;
+    Reset();
+    _eof = true;
+}
+
+
+// Makes sure count bytes are unconsumed, reading more input as needed. Returns false at the end of the input
+// (or on a read error). Reading may move the buffer, so pointers into it are only valid until the next call.
+bool XMLStreamReader::Ensure( size_t count )
+{
+    while ( _size - _pos < count ) {
+        if ( _eof ) {
+            return false;
+        }
+
+        // Keep only the unconsumed input, so the buffer grows only when a single tag or text run outgrows it
+        if ( _pos > 0 ) {
+            memmove( _buffer, _buffer + _pos, _size - _pos );
+            _size -= _pos;
+            _pos = 0;
+        }
+        if ( _capacity - _size < CHUNK_SIZE + 1 ) {
+            const size_t capacity = _capacity * 2 > _size + CHUNK_SIZE + 1 ? _capacity * 2 : _size + CHUNK_SIZE + 1;
+            char* buffer = new char[capacity];
+            if ( _buffer ) {
+                memcpy( buffer, _buffer, _size );
+            }
+            delete [] _buffer;
+            _buffer = buffer;
+            _capacity = capacity;
+        }
+
+        size_t read = 0;
+        if ( _source ) {
+            read = _sourceRemaining < static_cast<size_t>( CHUNK_SIZE ) ? _sourceRemaining : static_cast<size_t>( CHUNK_SIZE );
+            memcpy( _buffer + _size, _source, read );
+            _source += read;
+            _sourceRemaining -= read;
+        }
+        else if ( _fp ) {
+            read = fread( _buffer + _size, 1, CHUNK_SIZE, _fp );
+            if ( read < CHUNK_SIZE && ferror( _fp ) ) {
+                SetError( XML_ERROR_FILE_READ_ERROR, 0 );
+                _eof = true;
+            }
+        }
+        if ( read == 0 ) {
+            _eof = true;
+        }
+        _size += read;
+        _buffer[_size] = 0;
+    }
+    return true;
+}
+
+
+// Finds terminator at or after offset from, setting length to the offset just past it
+bool XMLStreamReader::Find( const char* terminator, size_t from, size_t* length )
+{
+    const size_t terminatorLength = strlen( terminator );
+    for ( size_t i = from; Ensure( i + terminatorLength ); ++i ) {
+        if ( _buffer[_pos + i] == terminator[0] && memcmp( _buffer + _pos + i, terminator, terminatorLength ) == 0 ) {
+            *length = i + terminatorLength;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Finds the '>' closing the tag at _pos, skipping any inside quoted attribute values
+bool XMLStreamReader::FindTagEnd( size_t* length )
+{
+    char quote = 0;
+    for ( size_t i = 1; Ensure( i + 1 ); ++i ) {
+        const char c = _buffer[_pos + i];
+        if ( quote ) {
+            if ( c == quote ) {
+                quote = 0;
+            }
+        }
+        else if ( c == '\"' || c == '\'' ) {
+            quote = c;
+        }
+        else if ( c == '>' ) {
+            *length = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void XMLStreamReader::Consume( size_t count )
+{
+    TIXMLASSERT( _pos + count <= _size );
+    for ( size_t i = 0; i < count; ++i ) {
+        if ( _buffer[_pos + i] == LF ) {
+            ++_lineNum;
+        }
+    }
+    _pos += count;
+}
+
+
+XMLStreamReader::Event XMLStreamReader::Next()
+{
+    if ( _event == END_DOCUMENT || _event == STREAM_ERROR ) {
+        return _event;
+    }
+    if ( _restoreChar ) {
+        _buffer[_pos] = _restoreChar;
+        _restoreChar = 0;
+    }
+    _text = 0;
+    _attributes.Clear();
+
+    if ( _popPending ) {
+        _names.PopArr( _names.Size() - _nameStarts.Pop() );
+        _popPending = false;
+    }
+    if ( _endPending ) {
+        _endPending = false;
+        _popPending = true;
+        return _event = END_ELEMENT;
+    }
+    if ( !_started ) {
+        _started = true;
+        if ( Ensure( 3 ) && static_cast<unsigned char>( _buffer[_pos] ) == TIXML_UTF_LEAD_0
+            && static_cast<unsigned char>( _buffer[_pos + 1] ) == TIXML_UTF_LEAD_1
+            && static_cast<unsigned char>( _buffer[_pos + 2] ) == TIXML_UTF_LEAD_2 ) {
+            _pos += 3;
+        }
+    }
+
+    for ( ;; ) {
+        // Whitespace between tags is skipped, but belongs to any text it leads into
+        size_t space = 0;
+        while ( Ensure( space + 1 ) && XMLUtil::IsWhiteSpace( _buffer[_pos + space] ) ) {
+            ++space;
+        }
+        if ( Error() ) {
+            return _event;
+        }
+        _eventLineNum = _lineNum;
+        if ( _size - _pos == space ) {
+            Consume( space );
+            if ( !_nameStarts.Empty() ) {
+                return SetError( XML_ERROR_PARSING_ELEMENT, _lineNum );
+            }
+            if ( !_sawElement ) {
+                return SetError( XML_ERROR_EMPTY_DOCUMENT, 0 );
+            }
+            return _event = END_DOCUMENT;
+        }
+        if ( _buffer[_pos + space] != '<' ) {
+            size_t length = space;
+            while ( Ensure( length + 1 ) && _buffer[_pos + length] != '<' ) {
+                ++length;
+            }
+            if ( Error() ) {
+                return _event;
+            }
+            return ReadText( 0, length, length, _processEntities ? StrPair::TEXT_ELEMENT : StrPair::TEXT_ELEMENT_LEAVE_ENTITIES );
+        }
+
+        Consume( space );
+        _eventLineNum = _lineNum;
+        Ensure( 9 );	// Long enough for "<![CDATA["; _buffer is null terminated if the input is shorter
+        const char* p = _buffer + _pos;
+        size_t length = 0;
+        if ( XMLUtil::StringEqual( p, "<?", 2 ) ) {
+            if ( !Find( "?>", 2, &length ) ) {
+                return SetError( XML_ERROR_PARSING_DECLARATION, _eventLineNum );
+            }
+            Consume( length );
+        }
+        else if ( XMLUtil::StringEqual( p, "<!--", 4 ) ) {
+            if ( !Find( "-->", 4, &length ) ) {
+                return SetError( XML_ERROR_PARSING_COMMENT, _eventLineNum );
+            }
+            Consume( length );
+        }
+        else if ( XMLUtil::StringEqual( p, "<![CDATA[", 9 ) ) {
+            if ( !Find( "]]>", 9, &length ) ) {
+                return SetError( XML_ERROR_PARSING_CDATA, _eventLineNum );
+            }
+            return ReadText( 9, length - 12, length, StrPair::NEEDS_NEWLINE_NORMALIZATION );
+        }
+        else if ( XMLUtil::StringEqual( p, "<!", 2 ) ) {
+            if ( !Find( ">", 2, &length ) ) {
+                return SetError( XML_ERROR_PARSING_UNKNOWN, _eventLineNum );
+            }
+            Consume( length );
+        }
+        else if ( XMLUtil::StringEqual( p, "</", 2 ) ) {
+            if ( !Find( ">", 2, &length ) ) {
+                return SetError( XML_ERROR_PARSING_ELEMENT, _eventLineNum );
+            }
+            return ReadEndTag( length );
+        }
+        else {
+            if ( !FindTagEnd( &length ) ) {
+                return SetError( XML_ERROR_PARSING_ELEMENT, _eventLineNum );
+            }
+            return ReadStartTag( length );
+        }
+        if ( Error() ) {
+            return _event;
+        }
+    }
+}
+
+
+XMLStreamReader::Event XMLStreamReader::ReadStartTag( size_t length )
+{
+    char* p = _buffer + _pos + 1;
+    char* const end = _buffer + _pos + length - 1;	// The '>'
+    if ( !XMLUtil::IsNameStartChar( static_cast<unsigned char>( *p ) ) ) {
+        return SetError( XML_ERROR_PARSING_ELEMENT, _eventLineNum );
+    }
+    if ( _nameStarts.Size() + 1 >= TINYXML2_MAX_ELEMENT_DEPTH ) {
+        return SetError( XML_ELEMENT_DEPTH_EXCEEDED, _eventLineNum );
+    }
+
+    const char* name = p;
+    while ( p < end && XMLUtil::IsNameChar( static_cast<unsigned char>( *p ) ) ) {
+        ++p;
+    }
+    const int nameLength = static_cast<int>( p - name );
+    _nameStarts.Push( _names.Size() );
+    char* copy = _names.PushArr( nameLength + 1 );
+    memcpy( copy, name, nameLength );
+    copy[nameLength] = 0;
+    _sawElement = true;
+
+    // Attribute names & values are terminated in place
+    while ( p < end ) {
+        while ( p < end && XMLUtil::IsWhiteSpace( *p ) ) {
+            ++p;
+        }
+        if ( p == end ) {
+            break;
+        }
+        if ( *p == '/' ) {
+            if ( p + 1 != end ) {
+                return SetError( XML_ERROR_PARSING_ELEMENT, _eventLineNum );
+            }
+            _endPending = true;
+            break;
+        }
+        if ( !XMLUtil::IsNameStartChar( static_cast<unsigned char>( *p ) ) ) {
+            return SetError( XML_ERROR_PARSING_ATTRIBUTE, _eventLineNum );
+        }
+
+        char* const attributeName = p;
+        while ( p < end && XMLUtil::IsNameChar( static_cast<unsigned char>( *p ) ) ) {
+            ++p;
+        }
+        char* const attributeNameEnd = p;
+        while ( p < end && XMLUtil::IsWhiteSpace( *p ) ) {
+            ++p;
+        }
+        if ( p == end || *p != '=' ) {
+            return SetError( XML_ERROR_PARSING_ATTRIBUTE, _eventLineNum );
+        }
+        ++p;
+        while ( p < end && XMLUtil::IsWhiteSpace( *p ) ) {
+            ++p;
+        }
+        if ( p == end || ( *p != SINGLE_QUOTE && *p != DOUBLE_QUOTE ) ) {
+            return SetError( XML_ERROR_PARSING_ATTRIBUTE, _eventLineNum );
+        }
+        char* const value = p + 1;
+        p = static_cast<char*>( memchr( value, *p, end - value ) );
+        if ( !p ) {
+            return SetError( XML_ERROR_PARSING_ATTRIBUTE, _eventLineNum );
+        }
+
+        *attributeNameEnd = 0;
+        if ( Attribute( attributeName ) ) {
+            return SetError( XML_ERROR_PARSING_ATTRIBUTE, _eventLineNum );
+        }
+        StrPair pair;
+        pair.Set( value, p, _processEntities ? StrPair::ATTRIBUTE_VALUE : StrPair::ATTRIBUTE_VALUE_LEAVE_ENTITIES );
+        _attributes.Push( attributeName );
+        _attributes.Push( pair.GetStr() );
+        ++p;
+    }
+
+    Consume( length );
+    return _event = START_ELEMENT;
+}
+
+
+XMLStreamReader::Event XMLStreamReader::ReadEndTag( size_t length )
+{
+    const char* p = _buffer + _pos + 2;
+    const char* const end = _buffer + _pos + length - 1;	// The '>'
+    const char* const name = p;
+    while ( p < end && XMLUtil::IsNameChar( static_cast<unsigned char>( *p ) ) ) {
+        ++p;
+    }
+    const size_t nameLength = p - name;
+    while ( p < end && XMLUtil::IsWhiteSpace( *p ) ) {
+        ++p;
+    }
+    if ( nameLength == 0 || p != end ) {
+        return SetError( XML_ERROR_PARSING_ELEMENT, _eventLineNum );
+    }
+    if ( _nameStarts.Empty() || strlen( Name() ) != nameLength || strncmp( Name(), name, nameLength ) != 0 ) {
+        return SetError( XML_ERROR_MISMATCHED_ELEMENT, _eventLineNum );
+    }
+
+    Consume( length );
+    _popPending = true;
+    return _event = END_ELEMENT;
+}
+
+
+// Text is [start, start + length) from _pos, and consumed bytes are skipped after it
+XMLStreamReader::Event XMLStreamReader::ReadText( size_t start, size_t length, size_t consumed, int flags )
+{
+    char* const text = _buffer + _pos + start;
+    StrPair pair;
+    pair.Set( text, text + length, flags );
+    Consume( consumed );
+
+    // The terminator may land on the first character of the next tag, which Next() puts back
+    _restoreChar = _buffer[_pos];
+    _text = pair.GetStr();
+    return _event = TEXT;
+}
+
+
+XMLStreamReader::Event XMLStreamReader::SetError( XMLError error, int lineNum )
+{
+    if ( _errorID == XML_SUCCESS ) {
+        _errorID = error;
+        _errorLineNum = lineNum;
+    }
+    return _event = STREAM_ERROR;
+}
+
+
+const char* XMLStreamReader::ErrorName() const
+{
+    return XMLDocument::ErrorIDToName( _errorID );
+}
+
+
+const char* XMLStreamReader::Name() const
+{
+    return _nameStarts.Empty() ? 0 : &_names[_nameStarts.PeekTop()];
+}
+
+
+const char* XMLStreamReader::Attribute( const char* name, const char* value ) const
+{
+    for ( int i = 0; i < _attributes.Size(); i += 2 ) {
+        if ( XMLUtil::StringEqual( _attributes[i], name ) ) {
+            if ( !value || XMLUtil::StringEqual( _attributes[i + 1], value ) ) {
+                return _attributes[i + 1];
+            }
+            return 0;
+        }
+    }
+    return 0;
+}
+
+
+XMLError XMLStreamReader::QueryIntAttribute( const char* name, int* value ) const
+{
+    const char* text = Attribute( name );
+    if ( !text ) {
+        return XML_NO_ATTRIBUTE;
+    }
+    return XMLUtil::ToInt( text, value ) ? XML_SUCCESS : XML_WRONG_ATTRIBUTE_TYPE;
+}
+
+
+XMLError XMLStreamReader::QueryUnsignedAttribute( const char* name, unsigned* value ) const
+{
+    const char* text = Attribute( name );
+    if ( !text ) {
+        return XML_NO_ATTRIBUTE;
+    }
+    return XMLUtil::ToUnsigned( text, value ) ? XML_SUCCESS : XML_WRONG_ATTRIBUTE_TYPE;
+}
+
+
+XMLError XMLStreamReader::QueryInt64Attribute( const char* name, int64_t* value ) const
+{
+    const char* text = Attribute( name );
+    if ( !text ) {
+        return XML_NO_ATTRIBUTE;
+    }
+    return XMLUtil::ToInt64( text, value ) ? XML_SUCCESS : XML_WRONG_ATTRIBUTE_TYPE;
+}
+
+
+XMLError XMLStreamReader::QueryBoolAttribute( const char* name, bool* value ) const
+{
+    const char* text = Attribute( name );
+    if ( !text ) {
+        return XML_NO_ATTRIBUTE;
+    }
+    return XMLUtil::ToBool( text, value ) ? XML_SUCCESS : XML_WRONG_ATTRIBUTE_TYPE;
+}
+
+
+XMLError XMLStreamReader::QueryFloatAttribute( const char* name, float* value ) const
+{
+    const char* text = Attribute( name );
+    if ( !text ) {
+        return XML_NO_ATTRIBUTE;
+    }
+    return XMLUtil::ToFloat( text, value ) ? XML_SUCCESS : XML_WRONG_ATTRIBUTE_TYPE;
+}
+
+
+XMLError XMLStreamReader::QueryDoubleAttribute( const char* name, double* value ) const
+{
+    const char* text = Attribute( name );
+    if ( !text ) {
+        return XML_NO_ATTRIBUTE;
+    }
+    return XMLUtil::ToDouble( text, value ) ? XML_SUCCESS : XML_WRONG_ATTRIBUTE_TYPE;
+}
+
+
 XMLPrinter::XMLPrinter( FILE* file, bool compact, int depth ) :
     _elementJustOpened( false ),
     _stack(),
@@ -372,18 +372,20 @@ public:
         return _currentAllocs;
     }
 
+    // Allocates blocks up front so that at least count items fit without growing.
+    void Reserve( int count ) {
+        while ( _blockPtrs.Size() * ITEMS_PER_BLOCK < count ) {
+            AddBlock();
+        }
+    }
+
+    int Capacity() const			{
+        return _blockPtrs.Size() * ITEMS_PER_BLOCK;
+    }
+
     virtual void* Alloc() {
         if ( !_root ) {
-            // Need a new block.
-            Block* block = new Block();
-            _blockPtrs.Push( block );
-
-            Item* blockItems = block->items;
-            for( int i = 0; i < ITEMS_PER_BLOCK - 1; ++i ) {
-                blockItems[i].next = &(blockItems[i + 1]);
-            }
-            blockItems[ITEMS_PER_BLOCK - 1].next = 0;
-            _root = blockItems;
+            AddBlock();
         }
         Item* const result = _root;
         TIXMLASSERT( result != 0 );
@@ -448,6 +450,20 @@ private:
     struct Block {
         Item items[ITEMS_PER_BLOCK];
     };
+
+    // Adds a new block's items to the free list.
+    void AddBlock() {
+        Block* block = new Block();
+        _blockPtrs.Push( block );
+
+        Item* blockItems = block->items;
+        for( int i = 0; i < ITEMS_PER_BLOCK - 1; ++i ) {
+            blockItems[i].next = &(blockItems[i + 1]);
+        }
+        blockItems[ITEMS_PER_BLOCK - 1].next = _root;
+        _root = blockItems;
+    }
+
     DynArray< Block*, 10 > _blockPtrs;
     Item* _root;
 
@@ -1902,9 +1918,23 @@ public:
         return _errorLineNum;
     }
 
-    /// Clear the document, resetting it to the initial state.
+    /**
+    	Clear the document, resetting it to the initial state. Memory is kept for
+    	the next Parse() or LoadFile(): node pools keep their blocks and the parse
+    	buffer is reused if it's big enough, so a document that's cleared and
+    	reloaded with similar files stops allocating.
+    */
     void Clear();
 
+    /**
+    	Grows the node pools up front so that many nodes of each kind can be
+    	created without allocating, for documents of a known size.
+    */
+    void Reserve( int elements, int attributes, int texts=0, int comments=0 );
+
+    /// Clear() the document and free the memory it keeps for reuse.
+    void ReleaseMemory();
+
 	/**
 		Copies this document to a target document.
 		The target will be completely cleared before the copy.
@@ -1938,6 +1968,10 @@ private:
     mutable StrPair	_errorStr;
     int             _errorLineNum;
     char*			_charBuffer;
+    size_t			_charBufferMapped;	// Length of the mapping _charBuffer points into, or 0 if it's from new[]
+    size_t			_charBufferSize;	// Allocated size of _charBuffer if it's from new[]
+    char*			_spareBuffer;		// A previous _charBuffer kept by Clear() for reuse
+    size_t			_spareBufferSize;
     int				_parseCurLineNum;
 	int				_parsingDepth;
 	// Memory tracking does add some overhead.
@@ -1956,6 +1990,8 @@ private:
 	static const char* _errorNames[XML_ERROR_COUNT];
 
     void Parse();
+    bool MapFile( FILE* fp, size_t size );
+    char* AllocCharBuffer( size_t size );
 
     void SetError( XMLError error, int lineNum, const char* format, ... );
 
@@ -2192,6 +2228,163 @@ private:
 };
 
 
+/**
+	Reads XML as a stream of events instead of building an XMLDocument. Only the
+	tag or text being read and the names of the open elements are held in memory,
+	so memory use depends on nesting depth rather than file size.
+
+	@verbatim
+	XMLStreamReader reader;
+	reader.Open( "Turrets.xml" );
+	XMLStreamReader::Event event;
+	while ( ( event = reader.Next() ) != XMLStreamReader::END_DOCUMENT && event != XMLStreamReader::STREAM_ERROR ) {
+		if ( event == XMLStreamReader::START_ELEMENT && reader.Depth() == 1 ) {
+			reader.QueryFloatAttribute( "x", &x );
+		}
+	}
+	@endverbatim
+
+	Names, attribute values and text are only valid until the next call to Next().
+	Declarations, comments, DOCTYPEs and whitespace-only text are skipped.
+*/
+class TINYXML2_LIB XMLStreamReader
+{
+public:
+    enum Event {
+        START_ELEMENT,	///< Name() and the attributes are set. Always followed by a matching END_ELEMENT, even for <empty/> elements.
+        END_ELEMENT,	///< Name() is set.
+        TEXT,			///< Text() is set. CDATA sections are returned as text.
+        END_DOCUMENT,
+        STREAM_ERROR	///< ErrorID() says why. Next() keeps returning this.
+    };
+
+    XMLStreamReader( bool processEntities = true );
+    ~XMLStreamReader();
+
+    /// Reads from a file. Returns XML_SUCCESS, or XML_ERROR_FILE_NOT_FOUND.
+    XMLError Open( const char* filename );
+    /// Reads from a file opened as binary ("rb"). You are responsible for closing the FILE* after the reader.
+    void Open( FILE* fp );
+    /// Reads from a string, which must outlive the reader. As with XMLDocument::Parse, nBytes defaults to strlen(xml).
+    void Parse( const char* xml, size_t nBytes=static_cast<size_t>(-1) );
+    /// Closes the input, if the reader opened it.
+    void Close();
+
+    /// Reads up to the next event.
+    Event Next();
+
+    /// The current element, for START_ELEMENT and END_ELEMENT.
+    const char* Name() const;
+    /// The text of a TEXT event.
+    const char* Text() const				{
+        return _text;
+    }
+    /// Number of open elements, counting the current START_ELEMENT or END_ELEMENT. 1 for the root element.
+    int Depth() const						{
+        return _nameStarts.Size();
+    }
+    /// The line the current event started on.
+    int LineNum() const						{
+        return _eventLineNum;
+    }
+
+    int AttributeCount() const				{
+        return _attributes.Size() / 2;
+    }
+    const char* AttributeName( int i ) const	{
+        return _attributes[i * 2];
+    }
+    const char* AttributeValue( int i ) const	{
+        return _attributes[i * 2 + 1];
+    }
+    /// Same as XMLElement::Attribute(), for the current START_ELEMENT.
+    const char* Attribute( const char* name, const char* value=0 ) const;
+
+    /// Same as the XMLElement queries: XML_SUCCESS, XML_NO_ATTRIBUTE or XML_WRONG_ATTRIBUTE_TYPE.
+    XMLError QueryIntAttribute( const char* name, int* value ) const;
+    XMLError QueryUnsignedAttribute( const char* name, unsigned* value ) const;
+    XMLError QueryInt64Attribute( const char* name, int64_t* value ) const;
+    XMLError QueryBoolAttribute( const char* name, bool* value ) const;
+    XMLError QueryFloatAttribute( const char* name, float* value ) const;
+    XMLError QueryDoubleAttribute( const char* name, double* value ) const;
+
+    XMLError QueryAttribute( const char* name, int* value ) const {
+        return QueryIntAttribute( name, value );
+    }
+    XMLError QueryAttribute( const char* name, unsigned* value ) const {
+        return QueryUnsignedAttribute( name, value );
+    }
+    XMLError QueryAttribute( const char* name, int64_t* value ) const {
+        return QueryInt64Attribute( name, value );
+    }
+    XMLError QueryAttribute( const char* name, bool* value ) const {
+        return QueryBoolAttribute( name, value );
+    }
+    XMLError QueryAttribute( const char* name, float* value ) const {
+        return QueryFloatAttribute( name, value );
+    }
+    XMLError QueryAttribute( const char* name, double* value ) const {
+        return QueryDoubleAttribute( name, value );
+    }
+
+    bool Error() const						{
+        return _errorID != XML_SUCCESS;
+    }
+    XMLError ErrorID() const				{
+        return _errorID;
+    }
+    const char* ErrorName() const;
+    /// The line the error was found on, or 0 if it isn't a parse error.
+    int ErrorLineNum() const				{
+        return _errorLineNum;
+    }
+
+private:
+    XMLStreamReader( const XMLStreamReader& );	// not supported
+    void operator=( const XMLStreamReader& );	// not supported
+
+    void Reset();
+    bool Ensure( size_t count );
+    bool Find( const char* terminator, size_t from, size_t* length );
+    bool FindTagEnd( size_t* length );
+    void Consume( size_t count );
+    Event ReadStartTag( size_t length );
+    Event ReadEndTag( size_t length );
+    Event ReadText( size_t start, size_t length, size_t consumed, int flags );
+    Event SetError( XMLError error, int lineNum );
+
+    enum { CHUNK_SIZE = 64 * 1024 };
+
+    bool		_processEntities;
+    FILE*		_fp;
+    bool		_ownsFile;
+    const char*	_source;			// String input, or null to read _fp
+    size_t		_sourceRemaining;
+    bool		_eof;
+
+    char*		_buffer;			// Unconsumed input is [_pos, _size). Always has room for a terminating null.
+    size_t		_capacity;
+    size_t		_size;
+    size_t		_pos;
+    int			_lineNum;			// Line of _buffer[_pos]
+
+    Event		_event;
+    int			_eventLineNum;
+    bool		_started;
+    bool		_sawElement;
+    bool		_endPending;		// The current start tag was <empty/>
+    bool		_popPending;		// The current event is END_ELEMENT
+    char		_restoreChar;		// Text() overwrote _buffer[_pos] with its terminator
+    const char*	_text;
+    DynArray< const char*, 16 >	_attributes;	// Name, value pairs
+    DynArray< char, 256 >		_names;			// Open element names, null terminated & back to back
+    DynArray< int, 16 >			_nameStarts;
+
+    XMLError	_errorID;
+    int			_errorLineNum;
+};
+
+
 /**
 	Printing functionality. The XMLPrinter gives you more
 	options than the XMLDocument::Print() method.